@@ -9,7 +9,7 @@
  * The solution is set to be periodic. (u=(1/(5*Pi*Pi))*sin*(Pi*x)*cos(2*Pi*x)).
  * See details in ReadMe.md
  * 
- * @see csr.h, poisson2d.h, grid.h
+ * @see csr.h, poisson2d.h, fastpoisson.h, grid.h, geometry.h
  * @author Li Zhijun
  * @date 2025-10-24
  * @example Dirichlet.c
@@ -19,53 +19,24 @@
 # include <math.h>
 # include <csr.h>
 # include <poisson2d.h>
+# include <fastpoisson.h>
+# include <geometry.h>
 # include <utils.h>
 # define Pi 3.14159265358979323846
 
-int region_divider(double x, double y, double hx, double hy) {
-    double eps = 1e-12;
-    if (y > 1.0 && y <= (2.0 + eps)) {
-        if (x >= (y - 1.0 - eps) && x <= (3.0 - y + eps)) {
-            if (x <= y - 1.0 + hx - 2 * eps) {
-                return 2; // Top left slant boundary
-            } else if (x >= 3.0 - y - hx + 2 * eps) {
-                return 3; // Top right slant boundary
-            } else {
-                return 1; // Active interior point
-            }
-        } else {
-            return 0;
-        }
-    }
-    else if (y > -1.0 && y <= 1.0) {
-        if (x >= -eps && x <= (0.5 * y + 1.5 + eps)) {
-            if (x <= hx - 2 *eps) {
-                return 4; // Left boundary
-            } else if (x >= 0.5 * y + 1.5 - hx + 2 * eps) {
-                return 5; // Upper right boundary
-            } else {
-                return 1; // Active interior point
-            }
-        } else {
-            return 0;
-        }
-    }
-    else if (y >= (-2.0 - eps) && y <= -1.0) {
-        if (x >= -eps && x <= (-y + eps)) {
-            if (x <= hx - 2 * eps) {
-                return 4; // Left boundary
-            } else if (x >= -y - hx + 2 * eps) {
-                return 6; // Lower right boundary
-            } else if (y <= -2.0 + hy - 2 * eps) {
-                return 7; // Bottom boundary
-            } else {
-                return 1; // Active interior point
-            }
-        } else {
-            return 0;
-        }
-    }
-};
+/*
+ * The computational region, counterclockwise from the bottom left corner, with the
+ * boundary type of every edge:
+ * 7 bottom, 6 lower right, 5 upper right, 3 top right slant, 2 top left slant, 4 left.
+ */
+Geometry2D* create_domain() {
+    double x[] = {0.0, 2.0, 1.0, 2.0, 1.0, 0.0};
+    double y[] = {-2.0, -2.0, -1.0, 1.0, 2.0, 1.0};
+    int tags[] = {7, 6, 5, 3, 2, 4};
+    Geometry2D *domain = create_Geometry2D();
+    add_polygon_Geometry2D(domain, 6, x, y, tags);
+    return domain;
+}
 
 double compute_f(double x, double y) {
     return sin(Pi * x) * cos(2 * Pi * y);
@@ -112,28 +83,20 @@ double compute_boundary_value(double x, double y, int boundary_type) {
 int main() {
     int nx = 41;
     int ny = 81;
-    Grid2D* grid = initialize_Grid(nx, ny, 0.0, 2.0, -2.0, 2.0, region_divider);
+    Geometry2D *domain = create_domain();
+    Grid2D* grid = initialize_Grid_geometry(nx, ny, 0.0, 2.0, -2.0, 2.0, domain);
+    free_Geometry2D(domain);
     // printf("Number of active grid points: %d\n", grid->n_active);
     // printf("%.6f\n", compute_u_exact(grid->x[10], grid->y[40]));
     printf("Grid region layout (0: exterior, 1: interior, others: boundary types):\n");
-    print_int_matrix((const int **)grid->region, grid->nx, grid->ny);
-    SparseCSR* matrix = assemble_Matrix_Dirichlet(grid);
-
-    // printf("Assembled sparse matrix in CSR format:\n");
-    // if (grid->n_active <= 36) {
-    //     print_SparseCSR(matrix, 1);
-    // } else {
-    //     printf("Matrix too large to display fully.\n");
-    //     print_SparseCSR_simple(matrix, 1);
-    // }
+    print_byte_matrix(grid->region, grid->nx, grid->ny);
 
     double* rhs = assemble_RHS_Dirichlet(grid, compute_f, compute_boundary_value);
-    // Solve the linear system using Conjugate Gradient method
+    // Solve the linear system with the fast (DST + capacitance matrix) Poisson solver
     double* solution = (double *)malloc(grid->n_active * sizeof(double));
-    for (int i = 0; i < grid->n_active; i++) {
-        solution[i] = 0.0; // Initial guess
-    }
-    GaussSeidel_csr_debug(matrix, rhs, solution, 1000, 1e-6);
+    FastPoisson *fast = create_Fast_Poisson(grid);
+    solve_Fast_Poisson(fast, rhs, solution, 1000, 1e-10);
+    free_Fast_Poisson(fast);
 
     double *exact = (double *)malloc(grid->n_active * sizeof(double));
     for (int i = 0; i < grid->n_active; i++) {
@@ -165,14 +128,13 @@ int main() {
     // Optionally, write the solution to a CSV file for visualization
     write_csv_matrix("results/Poisson/data/Dirichlet_solution.csv", data_points, grid->nx, grid->ny);
     write_csv_matrix("results/Poisson/data/Dirichlet_exact.csv", exact_points, grid->nx, grid->ny);
-    write_csv_int_matrix("results/Poisson/data/grid_data.csv", grid->region, grid->nx, grid->ny);
+    write_csv_byte_matrix("results/Poisson/data/grid_data.csv", grid->region, grid->nx, grid->ny);
     
     // Clean up
     // Save grid dimensions because free_grid(grid) will deallocate the structure
     int nx_grid = grid->nx;
     int ny_grid = grid->ny;
 
-    freeSparseCSR(matrix);
     free(rhs);
     free(exact);
     free(solution);
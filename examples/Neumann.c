@@ -149,31 +149,29 @@ double compute_boundary_value(double x, double y, int boundary_type) {
 
 double *numerical_deriv(Grid2D* grid, double*data_indices, int direction) {
     double *derivative = (double *)malloc(grid->n_active * sizeof(double));
-    int **region = grid->region, **id_map = grid->id_map;
     double hx = grid->hx, hy = grid->hy;
     for (int i = 0; i < grid->n_active; i++) {
-        int gi = grid->id_i[i];
-        int gj = grid->id_j[i];
+        const int *nb = grid_neighbors(grid, i);
         if (direction == 0) { // numerical derivative w.r.t x
-            if ((gi == 0) || (region[gi - 1][gj] == 0)) {
-                derivative[i] = (data_indices[id_map[gi + 1][gj]] - data_indices[i]) / hx;
+            if (nb[GRID_LEFT] < 0) {
+                derivative[i] = (data_indices[nb[GRID_RIGHT]] - data_indices[i]) / hx;
             }
-            else if ((gi == grid->nx-1) || (region[gi + 1][gj] == 0)) {
-                derivative[i] = (data_indices[i] - data_indices[id_map[gi - 1][gj]]) / hx;
+            else if (nb[GRID_RIGHT] < 0) {
+                derivative[i] = (data_indices[i] - data_indices[nb[GRID_LEFT]]) / hx;
             }
             else {
-                derivative[i] = (data_indices[id_map[gi + 1][gj]] - data_indices[id_map[gi - 1][gj]]) / hx / 2;
+                derivative[i] = (data_indices[nb[GRID_RIGHT]] - data_indices[nb[GRID_LEFT]]) / hx / 2;
             }
         }
         else if (direction == 1) { // numerical derivative w.r.t y
-            if ((gj == 0) || (region[gi][gj - 1] == 0)) {
-                derivative[i] = (data_indices[id_map[gi][gj + 1]] - data_indices[i]) / hy;
+            if (nb[GRID_DOWN] < 0) {
+                derivative[i] = (data_indices[nb[GRID_UP]] - data_indices[i]) / hy;
             }
-            else if ((gj == grid->ny-1) || (region[gi][gj + 1] == 0)) {
-                derivative[i] = (data_indices[i] - data_indices[id_map[gi][gj - 1]]) / hy;
+            else if (nb[GRID_UP] < 0) {
+                derivative[i] = (data_indices[i] - data_indices[nb[GRID_DOWN]]) / hy;
             }
             else {
-                derivative[i] = (data_indices[id_map[gi][gj + 1]] - data_indices[id_map[gi][gj - 1]]) / hy / 2;
+                derivative[i] = (data_indices[nb[GRID_UP]] - data_indices[nb[GRID_DOWN]]) / hy / 2;
             }
         }
     }
@@ -187,7 +185,7 @@ int main() {
     // printf("Number of active grid points: %d\n", grid->n_active);
     // printf("%.6f\n", compute_u_exact(grid->x[10], grid->y[40]));
     printf("Grid region layout (0: exterior, 1: interior, others: boundary types):\n");
-    print_int_matrix((const int **)grid->region, grid->nx, grid->ny);
+    print_byte_matrix(grid->region, grid->nx, grid->ny);
     SparseCSR* matrix = assemble_Matrix_Neumann(grid, get_normal);
 
     // printf("Assembled sparse matrix in CSR format:\n");
@@ -241,7 +239,7 @@ int main() {
     // Optionally, write the solution to a CSV file for visualization
     write_csv_matrix("results/Poisson/data/Neumann_solution.csv", data_points, grid->nx, grid->ny);
     write_csv_matrix("results/Poisson/data/Neumann_exact.csv", exact_points, grid->nx, grid->ny);
-    write_csv_int_matrix("results/Poisson/data/grid_data.csv", grid->region, grid->nx, grid->ny);
+    write_csv_byte_matrix("results/Poisson/data/grid_data.csv", grid->region, grid->nx, grid->ny);
 
     // Clean up
     // Save grid dimensions because free_grid(grid) will deallocate the structure
@@ -20,6 +20,7 @@
 # include <utils.h>
 # include <bessel.h>
 # include <parabolic.h>
+# include <spmv.h>
 
 int region_divider(double x, double y, double hx, double hy) {
     double eps = 1e-12;
@@ -129,19 +130,19 @@ int main(){
     int nx = 41;
     int ny = 81;
     Grid2D* grid = initialize_Grid(nx, ny, 0.0, 2.0, -2.0, 2.0, region_divider);
-    double tau = grid->hx * grid->hx * grid->hy * grid->hy / (grid->hx * grid->hx + grid->hy * grid->hy) / 2;
+    double tau = estimate_stable_tau_Parabolic_Explicit(grid, 0.95);
     SparseCSR* iteration_matrix = assemble_Matrix_Parabolic_Explicit(grid, tau);
+    tune_spmv_csr(iteration_matrix); // thousands of products follow: pick the fastest kernel once
     // printf("Number of active grid points: %d\n", grid->n_active);
     // printf("%.6f\n", compute_u_exact(grid->x[10], grid->y[40]));
     // printf("Grid region layout (0: exterior, 1: interior, others: boundary types):\n");
-    // print_int_matrix((const int **)grid->region, grid->nx, grid->ny);
+    // print_byte_matrix(grid->region, grid->nx, grid->ny);
     double t_now = 0.0;
     int step = 0;
     int output_interval = 100;
 
     double *exact = (double *)malloc(grid->n_active * sizeof(double));
     double *solution = (double *)malloc(grid->n_active * sizeof(double));
-    double *rhs = (double *)malloc(grid->n_active * sizeof(double));
     double *temp = (double *)malloc(grid->n_active * sizeof(double));
     
     double **exact_points = create_grid_2D_array(grid);
@@ -155,23 +156,25 @@ int main(){
         solution[i] = compute_u_exact(xi, yj, t_now, grid->hx, grid->hy);
     }
 
-    write_csv_int_matrix("results/Parabolic/data/Explicit/grid_data.csv", grid->region, grid->nx, grid->ny);
+    write_csv_byte_matrix("results/Parabolic/data/Explicit/grid_data.csv", grid->region, grid->nx, grid->ny);
 
     while (t_now < T_max) {
         t_now += tau;
         step ++;
-        spmv_csr(iteration_matrix, solution, temp);
-        assemble_RHS_Parabolic(grid, integrated_source_term, compute_boundary_value, rhs, t_now, tau);
-        for (int i = 0; i < grid->n_active; i++) {
-            int gi = grid->id_i[i];
-            int gj = grid->id_j[i];
-            double xi = grid->x[gi];
-            double yj = grid->y[gj];
-            solution[i] = temp[i] + rhs[i];
-            exact[i] = compute_u_exact(xi, yj, t_now, grid->hx, grid->hy);
-        }
+        // solution <- A * solution + rhs in one pass, then swap the buffers
+        step_Parabolic(grid, iteration_matrix, integrated_source_term, compute_boundary_value, solution, temp, t_now, tau);
+        double *swap = solution;
+        solution = temp;
+        temp = swap;
         if ((step % output_interval) == 0) {
             printf("Current Step: %06d, Writing Output\n", step);
+            for (int i = 0; i < grid->n_active; i++) {
+                int gi = grid->id_i[i];
+                int gj = grid->id_j[i];
+                double xi = grid->x[gi];
+                double yj = grid->y[gj];
+                exact[i] = compute_u_exact(xi, yj, t_now, grid->hx, grid->hy);
+            }
             read_indices_to_points(grid, exact, exact_points);
             read_indices_to_points(grid, solution, solution_points);
             
@@ -186,7 +189,6 @@ int main(){
 
     free(exact);
     free(solution);
-    free(rhs);
     free(temp);
     free_grid_2D_array(exact_points, grid);
     free_grid_2D_array(solution_points, grid);
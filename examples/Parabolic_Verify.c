@@ -87,7 +87,7 @@ int main(){
     // printf("Number of active grid points: %d\n", grid->n_active);
     // printf("%.6f\n", compute_u_exact(grid->x[10], grid->y[40]));
     // printf("Grid region layout (0: exterior, 1: interior, others: boundary types):\n");
-    // print_int_matrix((const int **)grid->region, grid->nx, grid->ny);
+    // print_byte_matrix(grid->region, grid->nx, grid->ny);
     double t_now = 0.0;
     int step = 0;
     int output_interval = 100;
@@ -107,7 +107,7 @@ int main(){
         exact[i] = compute_u_exact(xi, yj, t_now, grid->hx, grid->hy);
     }
 
-    write_csv_int_matrix("results/Parabolic/data/exact_test/grid_data.csv", grid->region, grid->nx, grid->ny);
+    write_csv_byte_matrix("results/Parabolic/data/exact_test/grid_data.csv", grid->region, grid->nx, grid->ny);
 
     while (t_now < T_max) {
         t_now += tau;
@@ -123,7 +123,7 @@ int main(){
         for (int i = 0; i < grid->n_active; i++) {
             int gi = grid->id_i[i];
             int gj = grid->id_j[i];
-            if (grid->region[gi][gj] == 1) {
+            if (grid_region(grid, gi, gj) == 1) {
                 rhs[i] = (exact[i] - compute[i]) * grid->hx * grid->hy / tau;
             }
             else {
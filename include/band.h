@@ -0,0 +1,82 @@
+/**
+ * @file band.h
+ * @brief Header file for bandwidth reduction and the banded LU solver.
+ *
+ * This header file declares the Reverse Cuthill-McKee (RCM) ordering, the
+ * bandwidth computation of a (permuted) CSR matrix, and a direct LU solver
+ * that factors the permuted matrix in dense band storage. For the tall but
+ * narrow grids of the examples the bandwidth is small enough that the band
+ * factorization is cheap and the solve is exact.
+ * @see band.c
+ * @author Li Zhijun
+ * @date 2025-12-13
+ */
+# ifndef BAND_H
+# define BAND_H
+# include "csr.h"
+
+/**
+ * @struct BandLU
+ * @brief LU factorization (without pivoting) of a permuted matrix in band storage.
+ *
+ * Row i of the permuted matrix P A P^T is stored contiguously as columns
+ * i - kl .. i + ku at band[i * ld + (j - i + kl)], so the elimination updates run
+ * over contiguous memory. L (unit lower) and U overwrite the band.
+ */
+typedef struct {
+    int n;          /**< Matrix size. */
+    int kl;         /**< Lower bandwidth. */
+    int ku;         /**< Upper bandwidth. */
+    int ld;         /**< Row stride of the band, kl + ku + 1. */
+    double *band;   /**< Band storage of L and U, n * ld doubles. */
+    int *perm;      /**< perm[k]: matrix row placed at position k. */
+    double *work;   /**< Work vector of length n. */
+} BandLU;
+
+/**
+ * @brief Compute the Reverse Cuthill-McKee ordering of a CSR matrix.
+ *
+ * Breadth-first search on the symmetrized pattern of A, starting from a
+ * pseudo-peripheral node of every connected component and visiting neighbours by
+ * increasing degree; the resulting order is reversed.
+ *
+ * @param matrix Pointer to the square SparseCSR matrix (A).
+ * @param perm Output array of length rows: perm[k] is the row placed at position k.
+ */
+void rcm_order_csr(const SparseCSR *matrix, int *perm);
+
+/**
+ * @brief Compute the lower and upper bandwidth of P A P^T.
+ * @param matrix Pointer to the square SparseCSR matrix (A).
+ * @param perm Ordering (perm[k] = row placed at position k), or NULL for none.
+ * @param kl Output: lower bandwidth, max(i - j) over the nonzeros.
+ * @param ku Output: upper bandwidth, max(j - i) over the nonzeros.
+ */
+void bandwidth_csr(const SparseCSR *matrix, const int *perm, int *kl, int *ku);
+
+/**
+ * @brief Factor a CSR matrix in band storage.
+ * @param matrix Pointer to the square SparseCSR matrix (A). No pivoting is done, so
+ *               A should be diagonally dominant or symmetric positive definite
+ *               (as are the assembled grid operators).
+ * @param perm Bandwidth-reducing ordering (e.g. from rcm_order_csr()), or NULL.
+ * @return Pointer to the factorization, or NULL if a zero pivot is met.
+ * @note The caller is responsible for freeing it using freeBandLU().
+ */
+BandLU* createBandLU(const SparseCSR *matrix, const int *perm);
+
+/**
+ * @brief Solve Ax = b with a computed band factorization.
+ * @param lu Pointer to the factorization.
+ * @param b Right-hand side vector.
+ * @param x Solution vector (may alias b).
+ */
+void solveBandLU(const BandLU *lu, const double *b, double *x);
+
+/**
+ * @brief Free a band factorization.
+ * @param lu Pointer to the factorization to free.
+ */
+void freeBandLU(BandLU *lu);
+
+# endif
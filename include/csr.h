@@ -4,9 +4,11 @@
  * 
  * This header file declares the SparseCSR structure and functions for
  * creating, freeing, decomposing, performing matrix-vector multiplication,
- * and solving linear systems using iterative methods (Jacobi, Gauss-Seidel,
- * Conjugate Gradient) for sparse matrices stored in Compressed Sparse Row (CSR)
- * format.
+ * and solving linear systems using iterative methods (Jacobi, Gauss-Seidel, SOR/SSOR,
+ * (preconditioned) Conjugate Gradient, s-step and deflated Conjugate Gradient,
+ * Chebyshev) for sparse matrices stored in Compressed Sparse Row (CSR) format,
+ * as well as estimating their extreme eigenvalues, transposing them and
+ * multiplying them.
  * @see csr.c
  * @author Li Zhijun
  * @date 2025-10-10
@@ -15,6 +17,15 @@
 # define CSR_H
 # include "vec.h"
 
+/** Sparse matrix-vector products with fewer nonzeros stay serial, the thread start-up would dominate. */
+# define CSR_PARALLEL_MIN_NNZ 100000
+
+/** Fused products adding a per-row term callback are threaded from this many rows on, the callbacks dominate their cost. */
+# define CSR_TERM_PARALLEL_MIN_ROWS 4096
+
+/** Opaque tuned SpMV kernel, see spmv.h. */
+typedef struct SpMVPlan SpMVPlan;
+
 /**
  * @struct SparseCSR
  * @brief Structure to represent a sparse matrix in Compressed Sparse Row (CSR) format.
@@ -31,8 +42,80 @@ typedef struct {
     int *row_ptr;   /**< Row pointer array of size 'rows + 1'. */
     int *col_ind;   /**< Column index array of size 'nnz'. */
     double *values; /**< Non-zero values array of size 'nnz'. */
+    SpMVPlan *plan; /**< Tuned SpMV kernel (see tune_spmv_csr()), NULL for the reference kernel. */
 } SparseCSR;
 
+/**
+ * @brief Preconditioner callback: z = M^{-1} r.
+ *
+ * `ctx` is the preconditioner object (e.g. an ILU0 from precond.h) passed
+ * through unchanged by the solver.
+ */
+typedef void (*precond_func)(const void *ctx, const double *r, double *z);
+
+/**
+ * @brief Row term callback of spmv_axpby_term_csr(): value added to row `row` of the product.
+ *
+ * `ctx` is passed through unchanged; the callback may be called from several OpenMP threads.
+ */
+typedef double (*csr_row_term)(int row, const void *ctx);
+
+/**
+ * @struct SplitCSR
+ * @brief Zero-copy D/L/U view of a SparseCSR matrix.
+ *
+ * With the columns of every row sorted, row i of the viewed matrix reads
+ * - L: [row_ptr[i], diag_ind[i]) (or up to upper_ptr[i] if there is no diagonal)
+ * - D: values[diag_ind[i]]
+ * - U: [upper_ptr[i], row_ptr[i + 1])
+ *
+ * so triangular sweeps and Jacobi-style iterations work on the original arrays
+ * instead of the copies made by get_D_L_U_csr().
+ */
+typedef struct {
+    const SparseCSR *matrix;    /**< Viewed matrix (columns sorted within each row). */
+    int *diag_ind;              /**< Index of the diagonal entry of each row, -1 if absent. */
+    int *upper_ptr;             /**< Index of the first strictly upper entry of each row. */
+} SplitCSR;
+
+/** Default number of solves between two refreshes of a RecycleSpace. */
+# define RECYCLE_REFRESH_PERIOD 200
+
+/**
+ * @struct RecycleSpace
+ * @brief Krylov subspace recycled between solves with the same matrix.
+ *
+ * Holds up to k vectors W with W^T A W = I together with A*W, plus room for m
+ * search directions harvested during a refresh solve. After such a solve the
+ * space is replaced by the k Ritz vectors of span([W, P]) belonging to the
+ * smallest eigenvalues, so the slowest converging modes are deflated from the
+ * following solves. A refresh costs O((k + m)^2 n), far more than a CG iteration,
+ * so it only happens on the first solve, every refresh_period solves, and when the
+ * iteration count has grown by a quarter over the first solve after the last refresh.
+ */
+typedef struct {
+    int n;          /**< Length of the vectors. */
+    int k;          /**< Maximum number of recycled vectors. */
+    int m;          /**< Number of search directions harvested per solve. */
+    int n_vec;      /**< Number of recycled vectors currently stored. */
+    int n_dir;      /**< Number of search directions harvested so far in the current solve. */
+    double *W;      /**< Recycled vectors followed by harvested directions, (k + m) * n doubles. */
+    double *AW;     /**< A times the columns of W, (k + m) * n doubles. */
+    int refresh_period; /**< Solves between two refreshes of the space (default RECYCLE_REFRESH_PERIOD). */
+    int n_solves;   /**< Solves since the last refresh. */
+    int base_iter;  /**< Iterations of the first solve after the last refresh, -1 if not known yet. */
+    int stale;      /**< Set when the iteration count has grown, forces a refresh on the next solve. */
+} RecycleSpace;
+
+/**
+ * @enum krylov_basis_type
+ * @brief Polynomial basis used by the s-step Krylov methods.
+ */
+typedef enum {
+    KRYLOV_BASIS_MONOMIAL,  /**< Scaled monomial basis (A/lambda_max)^k v; simple but ill-conditioned for large s. */
+    KRYLOV_BASIS_NEWTON     /**< Newton basis with Leja-ordered Chebyshev shifts; stable for larger s. */
+} krylov_basis_type;
+
 /**
  * @brief Create a new SparseCSR matrix structure.
  * @param rows Number of rows.
@@ -53,12 +136,50 @@ void freeSparseCSR(SparseCSR *matrix);
 
 /**
  * @brief Sparse matrix-vector multiplication (y = A*x) for CSR format.
+ *
+ * Runs the kernel selected by tune_spmv_csr() when the matrix has been tuned.
+ *
  * @param matrix Pointer to the SparseCSR matrix.
  * @param x Input vector.
  * @param y Output vector (result).
  */
 void spmv_csr(const SparseCSR *matrix, const double *x, double *y);
 
+/**
+ * @brief Fused product y = alpha*A*x + beta*y + b in a single pass over y.
+ *
+ * Replaces spmv_csr() into a temporary followed by a vector update, so every
+ * vector is read and written once. Each row is summed in CSR order, like the
+ * reference spmv_csr(), by the kernel selected by tune_spmv_csr() when the matrix
+ * has been tuned; rows are distributed over the OpenMP threads.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param alpha Scale of the product.
+ * @param x Input vector (must not alias y).
+ * @param beta Scale of the old y; y is not read when beta is 0.
+ * @param y Input/output vector.
+ * @param b Vector added to the result, or NULL.
+ */
+void spmv_axpby_csr(const SparseCSR *matrix, double alpha, const double *x, double beta, double *y, const double *b);
+
+/**
+ * @brief Fused product y[i] = alpha*(A*x)[i] + beta*y[i] + term(i, ctx) in a single pass over y.
+ *
+ * Same as spmv_axpby_csr() with a right-hand side computed row by row while the row
+ * is written, e.g. from source term and boundary callbacks, so it needs no vector of
+ * its own. From CSR_TERM_PARALLEL_MIN_ROWS rows on the rows are threaded, whatever the
+ * size of the matrix or the kernel selected by tune_spmv_csr().
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param alpha Scale of the product.
+ * @param x Input vector (must not alias y).
+ * @param beta Scale of the old y; y is not read when beta is 0.
+ * @param y Input/output vector.
+ * @param term Row term callback.
+ * @param ctx Context passed to the callback.
+ */
+void spmv_axpby_term_csr(const SparseCSR *matrix, double alpha, const double *x, double beta, double *y, csr_row_term term, const void *ctx);
+
 /**
  * @brief Decompose a CSR matrix into diagonal, lower, and upper matrices.
  *
@@ -69,9 +190,82 @@ void spmv_csr(const SparseCSR *matrix, const double *x, double *y);
  *
  * @param matrix Pointer to the input SparseCSR matrix.
  * @return Array of three SparseCSR* (D, L, U)
+ * @note Every nonzero is copied; use createSplitCSR() to split without copying.
  */
 SparseCSR** get_D_L_U_csr(const SparseCSR *matrix);
 
+/**
+ * @brief Sort the column indices (and values) of every row in ascending order.
+ * @param matrix Pointer to the SparseCSR matrix, modified in place.
+ */
+void sort_columns_csr(SparseCSR *matrix);
+
+/**
+ * @brief Create a zero-copy D/L/U view of a CSR matrix.
+ *
+ * Sorts the columns of every row in place (the represented matrix is unchanged),
+ * then records the diagonal position and the lower/upper split point of each row.
+ *
+ * @param matrix Pointer to the SparseCSR matrix; must outlive the view.
+ * @return Pointer to the newly allocated view.
+ * @note The caller is responsible for freeing the view using freeSplitCSR().
+ *       The matrix itself is not freed by freeSplitCSR().
+ */
+SplitCSR* createSplitCSR(SparseCSR *matrix);
+
+/**
+ * @brief Free a D/L/U view (not the viewed matrix).
+ * @param split Pointer to the view to free.
+ */
+void freeSplitCSR(SplitCSR *split);
+
+/**
+ * @brief Extract the diagonal of the viewed matrix (0 where absent).
+ * @param split Pointer to the view.
+ * @param d Output vector of length rows.
+ */
+void get_diag_split_csr(const SplitCSR *split, double *d);
+
+/**
+ * @brief Strictly lower product y = L*x.
+ * @param split Pointer to the view.
+ * @param x Input vector.
+ * @param y Output vector.
+ */
+void spmv_lower_split_csr(const SplitCSR *split, const double *x, double *y);
+
+/**
+ * @brief Strictly upper product y = U*x.
+ * @param split Pointer to the view.
+ * @param x Input vector.
+ * @param y Output vector.
+ */
+void spmv_upper_split_csr(const SplitCSR *split, const double *x, double *y);
+
+/**
+ * @brief Off-diagonal product y = (L + U)*x, as used by Jacobi-style iterations.
+ * @param split Pointer to the view.
+ * @param x Input vector.
+ * @param y Output vector.
+ */
+void spmv_offdiag_split_csr(const SplitCSR *split, const double *x, double *y);
+
+/**
+ * @brief Forward triangular solve (D + L)x = b.
+ * @param split Pointer to the view; every row must have a nonzero diagonal.
+ * @param b Right-hand side vector.
+ * @param x Solution vector (may alias b).
+ */
+void lower_solve_split_csr(const SplitCSR *split, const double *b, double *x);
+
+/**
+ * @brief Backward triangular solve (D + U)x = b.
+ * @param split Pointer to the view; every row must have a nonzero diagonal.
+ * @param b Right-hand side vector.
+ * @param x Solution vector (may alias b).
+ */
+void upper_solve_split_csr(const SplitCSR *split, const double *b, double *x);
+
 /**
  * @brief Solve Ax = b using the Jacobi iterative method for CSR matrices.
  * @param matrix Pointer to the SparseCSR matrix (A).
@@ -114,6 +308,89 @@ void GaussSeidel_csr_debug(const SparseCSR *matrix, const double *b, double *x,
  */
 void GaussSeidel_csr(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol);
 
+/**
+ * @brief Estimate the optimal SOR relaxation parameter of a matrix.
+ *
+ * Estimates the spectral radius rho of the Jacobi iteration matrix I - D^{-1}A with
+ * Lanczos on D^{-1/2} A D^{-1/2} (doubling the number of steps until the estimate
+ * settles) and returns Young's omega = 2 / (1 + sqrt(1 - rho^2)), which is optimal
+ * for consistently ordered matrices such as the 5-point grid operators.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A), symmetric with a positive diagonal.
+ * @return Relaxation parameter in [1, 2); 1 (Gauss-Seidel) if rho could not be
+ *         estimated below 1.
+ * @note The estimate of rho is approached from below, so omega errs on the small side.
+ */
+double estimate_SOR_omega_csr(const SparseCSR *matrix);
+
+/**
+ * @brief Estimate a good SSOR relaxation parameter of a matrix.
+ *
+ * Same estimate of the Jacobi spectral radius as estimate_SOR_omega_csr(), turned
+ * into omega = 2 / (1 + sqrt(2 (1 - rho))), the usual choice for symmetric sweeps
+ * over the 5-point grid operators.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A), symmetric with a positive diagonal.
+ * @return Relaxation parameter in [1, 2).
+ */
+double estimate_SSOR_omega_csr(const SparseCSR *matrix);
+
+/**
+ * @brief Solve Ax = b using successive over-relaxation (SOR) for CSR matrices.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param omega Relaxation parameter in (0, 2), or <= 0 to use estimate_SOR_omega_csr().
+ * @param max_iter Maximum number of iterations.
+ * @param tol Tolerance for convergence.
+ * @note This function will print omega and the residuals every step.
+ */
+void SOR_csr_debug(const SparseCSR *matrix, const double *b, double *x, double omega, int max_iter, double tol);
+
+/**
+ * @brief Solve Ax = b using successive over-relaxation (SOR) for CSR matrices.
+ *
+ * Gauss-Seidel sweeps whose updates are scaled by omega. With the optimal omega the
+ * number of sweeps on the grid operators grows like O(1/h) instead of the O(1/h^2)
+ * of Gauss-Seidel (omega = 1).
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param omega Relaxation parameter in (0, 2), or <= 0 to use estimate_SOR_omega_csr().
+ * @param max_iter Maximum number of iterations.
+ * @param tol Tolerance for convergence (on the update of a sweep).
+ */
+void SOR_csr(const SparseCSR *matrix, const double *b, double *x, double omega, int max_iter, double tol);
+
+/**
+ * @brief Solve Ax = b using symmetric SOR (SSOR) for CSR matrices.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param omega Relaxation parameter in (0, 2), or <= 0 to use estimate_SSOR_omega_csr().
+ * @param max_iter Maximum number of iterations.
+ * @param tol Tolerance for convergence.
+ * @note This function will print omega and the residuals every step.
+ */
+void SSOR_csr_debug(const SparseCSR *matrix, const double *b, double *x, double omega, int max_iter, double tol);
+
+/**
+ * @brief Solve Ax = b using symmetric SOR (SSOR) for CSR matrices.
+ *
+ * Every iteration is a forward SOR sweep followed by a backward one, which makes the
+ * iteration symmetric for symmetric A (see apply_SSOR() in precond.h for its use as
+ * a CG preconditioner).
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param omega Relaxation parameter in (0, 2), or <= 0 to use estimate_SSOR_omega_csr().
+ * @param max_iter Maximum number of iterations.
+ * @param tol Tolerance for convergence (on the update of both sweeps).
+ */
+void SSOR_csr(const SparseCSR *matrix, const double *b, double *x, double omega, int max_iter, double tol);
+
 /**
  * @brief Solve Ax = b using the Conjugate Gradient method for CSR matrices.
  * @param matrix Pointer to the SparseCSR matrix (A).
@@ -135,4 +412,255 @@ void CG_csr_debug(const SparseCSR *matrix, const double *b, double *x, int max_i
  */
 void CG_csr(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol);
 
+/**
+ * @brief Solve Ax = b using the preconditioned Conjugate Gradient method.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param precond Preconditioner callback, or NULL for plain CG.
+ * @param ctx Preconditioner object passed to precond.
+ * @param max_iter Maximum number of iterations.
+ * @param tol Tolerance for convergence.
+ * @note This function will print residuals every step.
+ */
+void PCG_csr_debug(const SparseCSR *matrix, const double *b, double *x, precond_func precond, const void *ctx, int max_iter, double tol);
+
+/**
+ * @brief Solve Ax = b using the preconditioned Conjugate Gradient method.
+ *
+ * Rows that only hold their diagonal entry (Dirichlet rows) are solved exactly
+ * before iterating, so A and a symmetric preconditioner only act on the coupled,
+ * symmetric block.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param precond Preconditioner callback, or NULL for plain CG.
+ * @param ctx Preconditioner object passed to precond.
+ * @param max_iter Maximum number of iterations.
+ * @param tol Tolerance for convergence.
+ */
+void PCG_csr(const SparseCSR *matrix, const double *b, double *x, precond_func precond, const void *ctx, int max_iter, double tol);
+
+/**
+ * @brief Estimate the largest eigenvalue magnitude of a CSR matrix by power iteration.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param max_iter Maximum number of iterations.
+ * @param tol Relative tolerance on the change of the estimate.
+ * @return Estimate of |lambda|_max, approached from below.
+ * @note Works for non-symmetric matrices with a real dominant eigenvalue, but converges
+ *       slowly when the two largest eigenvalues are close. Prefer Lanczos_eig_bounds_csr()
+ *       for symmetric matrices.
+ */
+double power_iteration_csr(const SparseCSR *matrix, int max_iter, double tol);
+
+/**
+ * @brief Estimate the smallest and largest eigenvalues of a symmetric CSR matrix by Lanczos.
+ *
+ * Runs n_iter steps of the Lanczos process (without reorthogonalization) and returns
+ * the extreme Ritz values of the resulting tridiagonal matrix. The extreme Ritz values
+ * converge much faster than power iteration, typically 20-40 steps are enough.
+ * Rows that only hold their diagonal entry (Dirichlet rows) are excluded from the
+ * start vector, so the estimate covers the coupled block of the matrix only.
+ *
+ * @param matrix Pointer to the symmetric SparseCSR matrix (A).
+ * @param n_iter Number of Lanczos steps (clamped to the matrix size).
+ * @param lambda_min Output: estimate of the smallest eigenvalue (approached from above).
+ * @param lambda_max Output: estimate of the largest eigenvalue (approached from below).
+ * @note Ritz values lie inside the spectrum, so widen the interval slightly
+ *       (e.g. 1.05 * lambda_max) before using it for Chebyshev_csr().
+ */
+void Lanczos_eig_bounds_csr(const SparseCSR *matrix, int n_iter, double *lambda_min, double *lambda_max);
+
+/**
+ * @brief Solve Ax = b using Chebyshev semi-iteration for CSR matrices.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param lambda_min Lower bound of the spectrum of A (must be > 0).
+ * @param lambda_max Upper bound of the spectrum of A.
+ * @param max_iter Maximum number of iterations.
+ * @param tol Tolerance for convergence.
+ * @note This function will print residuals every step.
+ * @see Lanczos_eig_bounds_csr()
+ */
+void Chebyshev_csr_debug(const SparseCSR *matrix, const double *b, double *x, double lambda_min, double lambda_max, int max_iter, double tol);
+
+/**
+ * @brief Solve Ax = b using Chebyshev semi-iteration for CSR matrices.
+ *
+ * Unlike CG, the iteration needs no inner products: the step lengths are fixed
+ * by the spectral interval [lambda_min, lambda_max]. The residual norm is only
+ * evaluated every few iterations to test for convergence. Rows that only hold
+ * their diagonal entry (Dirichlet rows) are solved exactly before iterating.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param lambda_min Lower bound of the spectrum of A (must be > 0).
+ * @param lambda_max Upper bound of the spectrum of A.
+ * @param max_iter Maximum number of iterations.
+ * @param tol Tolerance for convergence.
+ * @see Lanczos_eig_bounds_csr()
+ */
+void Chebyshev_csr(const SparseCSR *matrix, const double *b, double *x, double lambda_min, double lambda_max, int max_iter, double tol);
+
+/**
+ * @brief Apply a fixed number of Chebyshev steps to Ax = b (smoother, no convergence test).
+ *
+ * Used as a multigrid smoother, the interval is usually chosen as
+ * [lambda_max / 30, 1.1 * lambda_max] so that only the upper part of the spectrum is damped.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: smoothed result).
+ * @param lambda_min Lower end of the interval to damp.
+ * @param lambda_max Upper end of the interval to damp.
+ * @param n_steps Number of Chebyshev steps.
+ */
+void Chebyshev_smooth_csr(const SparseCSR *matrix, const double *b, double *x, double lambda_min, double lambda_max, int n_steps);
+
+/**
+ * @brief Matrix-powers kernel: compute a Krylov basis of s + 1 vectors.
+ *
+ * Computes V_0 = v and V_{k+1} = (A - shifts[k] I) V_k / scales[k] for k < s.
+ * Rows are processed in blocks along a skewed wavefront (level k lags level k-1
+ * by the matrix bandwidth), so all s levels of a block are computed while it is
+ * still cache resident instead of streaming the matrix s times.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param v Start vector of length rows.
+ * @param s Number of matrix powers to apply (s >= 0; s = 0 only copies v, s < 0 returns without writing V).
+ * @param shifts Array of s shifts, or NULL for the monomial basis.
+ * @param scales Array of s scaling factors, or NULL for no scaling.
+ * @param V Output array of (s + 1) * rows doubles, vector k stored at V + k * rows.
+ * @note The blocking pays off for banded matrices such as the grid operators
+ *       (bandwidth of about one grid line).
+ */
+void matrix_powers_csr(const SparseCSR *matrix, const double *v, int s, const double *shifts, const double *scales, double *V);
+
+/**
+ * @brief Solve Ax = b using the s-step (communication-avoiding) Conjugate Gradient method.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param s Number of CG iterations per block (s >= 1, typically 4-8); for s < 1 x is left unchanged.
+ * @param basis Krylov basis used for the block.
+ * @param max_iter Maximum number of CG iterations.
+ * @param tol Tolerance for convergence.
+ * @note This function will print residuals every step.
+ */
+void sstep_CG_csr_debug(const SparseCSR *matrix, const double *b, double *x, int s, krylov_basis_type basis, int max_iter, double tol);
+
+/**
+ * @brief Solve Ax = b using the s-step (communication-avoiding) Conjugate Gradient method.
+ *
+ * Each block builds the bases P = [p, ..., A^s p] and R = [r, ..., A^{s-1} r] with
+ * matrix_powers_csr(), forms their Gram matrix in a single reduction, and then
+ * performs s CG iterations on the small coordinate vectors. In exact arithmetic
+ * the iterates equal those of CG_csr(). Rows that only hold their diagonal entry
+ * (Dirichlet rows) are solved exactly before iterating.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A), symmetric positive definite.
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param s Number of CG iterations per block (s >= 1, typically 4-8); for s < 1 x is left unchanged.
+ * @param basis Krylov basis used for the block; prefer KRYLOV_BASIS_NEWTON for s > 4.
+ * @param max_iter Maximum number of CG iterations.
+ * @param tol Tolerance for convergence (on the recurrence residual).
+ */
+void sstep_CG_csr(const SparseCSR *matrix, const double *b, double *x, int s, krylov_basis_type basis, int max_iter, double tol);
+
+/**
+ * @brief Create an empty recycle space for deflated_CG_csr().
+ * @param n Size of the linear systems.
+ * @param k Maximum number of recycled vectors (typically 2-4).
+ * @param m Number of search directions harvested per refresh (typically 2k).
+ * @return Pointer to the newly allocated RecycleSpace structure.
+ *
+ * @note The caller is responsible for freeing the allocated memory using freeRecycleSpace().
+ * @note A space must only be reused with the same matrix.
+ */
+RecycleSpace* createRecycleSpace(int n, int k, int m);
+
+/**
+ * @brief Free the memory allocated for a RecycleSpace.
+ * @param space Pointer to the RecycleSpace structure to free.
+ */
+void freeRecycleSpace(RecycleSpace *space);
+
+/**
+ * @brief Solve Ax = b using deflated Conjugate Gradient with a recycled subspace.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param space Recycle space, updated on return.
+ * @param max_iter Maximum number of iterations.
+ * @param tol Tolerance for convergence.
+ * @return Number of iterations performed.
+ * @note This function will print residuals every step.
+ */
+int deflated_CG_csr_debug(const SparseCSR *matrix, const double *b, double *x, RecycleSpace *space, int max_iter, double tol);
+
+/**
+ * @brief Solve Ax = b using deflated Conjugate Gradient with a recycled subspace.
+ *
+ * Intended for sequences of systems with the same matrix, such as implicit time
+ * steps. The initial guess is first corrected on span(W), and every search
+ * direction is kept A-orthogonal to span(W) (Def-CG). On refresh solves (see
+ * RecycleSpace) the first search directions are harvested to rebuild the space;
+ * the other solves only pay the projection, O(k n) per iteration. Rows that only
+ * hold their diagonal entry (Dirichlet rows) are solved exactly before iterating.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A), symmetric positive definite.
+ * @param b Right-hand side vector.
+ * @param x Solution vector (input: initial guess, output: result).
+ * @param space Recycle space created for this matrix, updated on return.
+ * @param max_iter Maximum number of iterations.
+ * @param tol Tolerance for convergence.
+ * @return Number of iterations performed.
+ */
+int deflated_CG_csr(const SparseCSR *matrix, const double *b, double *x, RecycleSpace *space, int max_iter, double tol);
+
+/**
+ * @brief Transpose a CSR matrix (OpenMP-parallel).
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @return Newly allocated A^T, with sorted columns in every row.
+ * @note The caller is responsible for freeing the result using freeSparseCSR().
+ */
+SparseCSR* transpose_csr(const SparseCSR *matrix);
+
+/**
+ * @brief Symbolic phase of the sparse matrix-matrix product C = A*B.
+ *
+ * Computes the sparsity pattern of C (sorted columns, values set to zero) in two
+ * parallel passes: counting the row lengths, then filling the column indices.
+ * The pattern only depends on the patterns of A and B, so it can be reused by
+ * spgemm_numeric_csr() whenever only the values change (e.g. a new time-step).
+ *
+ * @param A Pointer to the left SparseCSR matrix.
+ * @param B Pointer to the right SparseCSR matrix (B->rows == A->cols).
+ * @return Newly allocated C with its pattern set.
+ * @note The caller is responsible for freeing the result using freeSparseCSR().
+ */
+SparseCSR* spgemm_symbolic_csr(const SparseCSR *A, const SparseCSR *B);
+
+/**
+ * @brief Numeric phase of the sparse matrix-matrix product C = A*B.
+ * @param A Pointer to the left SparseCSR matrix.
+ * @param B Pointer to the right SparseCSR matrix.
+ * @param C Product whose pattern was computed by spgemm_symbolic_csr() for A and B
+ *          (or for matrices with the same patterns); its values are overwritten.
+ */
+void spgemm_numeric_csr(const SparseCSR *A, const SparseCSR *B, SparseCSR *C);
+
+/**
+ * @brief Sparse matrix-matrix product C = A*B (symbolic and numeric phases).
+ * @param A Pointer to the left SparseCSR matrix.
+ * @param B Pointer to the right SparseCSR matrix.
+ * @return Newly allocated product C.
+ * @note The caller is responsible for freeing the result using freeSparseCSR().
+ */
+SparseCSR* spgemm_csr(const SparseCSR *A, const SparseCSR *B);
+
 # endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+/**
+ * @file csrf.h
+ * @brief Header file for CSR matrices with single-precision values.
+ *
+ * This header file declares SparseCSRf, a CSR matrix whose nonzero values are
+ * stored as float while the vectors and all accumulations stay in double. The
+ * finite-difference coefficients of the grid operators (1/h^2, tau/h^2, ...) are
+ * exactly representable or nearly so in float, so halving the value array cuts
+ * the memory traffic of the product by about a third at a negligible accuracy
+ * cost. Use float_rounding_csr() to check that cost before converting.
+ * @see csrf.c, csr.h
+ * @author Li Zhijun
+ * @date 2025-12-18
+ */
+# ifndef CSRF_H
+# define CSRF_H
+# include "csr.h"
+
+/**
+ * @struct SparseCSRf
+ * @brief CSR matrix with single-precision values.
+ *
+ * Same layout as SparseCSR, only `values` is stored as float.
+ */
+typedef struct {
+    int rows;       /**< Number of rows in the matrix. */
+    int cols;       /**< Number of columns in the matrix. */
+    int nnz;        /**< Number of non-zero elements in the matrix. */
+    int *row_ptr;   /**< Row pointer array of size 'rows + 1'. */
+    int *col_ind;   /**< Column index array of size 'nnz'. */
+    float *values;  /**< Non-zero values array of size 'nnz', rounded to float. */
+} SparseCSRf;
+
+/**
+ * @brief Create a single-precision copy of a CSR matrix.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @return Pointer to the newly allocated SparseCSRf, values rounded to nearest.
+ * @note The caller is responsible for freeing the allocated memory using freeSparseCSRf().
+ * @see float_rounding_csr()
+ */
+SparseCSRf* createSparseCSRf(const SparseCSR *matrix);
+
+/**
+ * @brief Free the memory allocated for a SparseCSRf matrix.
+ * @param matrix Pointer to the SparseCSRf structure to free.
+ */
+void freeSparseCSRf(SparseCSRf *matrix);
+
+/**
+ * @brief Sparse matrix-vector multiplication (y = A*x), float values, double accumulation.
+ *
+ * Every value is widened to double before the multiply-add, so the only error
+ * compared with spmv_csr() on the original matrix is the rounding of the
+ * coefficients themselves. Rows are distributed over the OpenMP threads; each row
+ * is summed in CSR order, so the result does not depend on the number of threads.
+ *
+ * @param matrix Pointer to the SparseCSRf matrix.
+ * @param x Input vector.
+ * @param y Output vector (result).
+ */
+void spmv_csrf(const SparseCSRf *matrix, const double *x, double *y);
+
+/**
+ * @brief Largest relative rounding error of the values of a CSR matrix stored as float.
+ *
+ * Returns max |a_ij - fl(a_ij)| / |a_ij| over the nonzero values (0 if all of them
+ * are exactly representable, infinity if one overflows). The relative error of
+ * spmv_csrf() against spmv_csr() is bounded by this value times the condition
+ * of the row sums, sum |a_ij x_j| / |sum a_ij x_j|.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @return Maximum relative coefficient rounding, at most 2^-24 for normal floats.
+ */
+double float_rounding_csr(const SparseCSR *matrix);
+
+# endif
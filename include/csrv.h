@@ -0,0 +1,77 @@
+/**
+ * @file csrv.h
+ * @brief Header file for value-indexed CSR matrices.
+ *
+ * This header file declares SparseCSRv, a CSR matrix for operators with few
+ * distinct coefficients. The grid assemblers produce only 2-5 of them (4, -1 and 1
+ * for the Dirichlet problem, 1 - 2(mu_x + mu_y), mu_x and mu_y for the explicit
+ * parabolic step), so every nonzero stores a 1-byte index into a small table of
+ * values instead of the value itself, cutting the value stream from 8 bytes to 1
+ * byte per nonzero.
+ * @see csrv.c, csr.h
+ * @author Li Zhijun
+ * @date 2025-12-19
+ */
+# ifndef CSRV_H
+# define CSRV_H
+# include "csr.h"
+
+/** Maximum number of distinct values a SparseCSRv can hold (1-byte indices). */
+# define CSRV_MAX_VALUES 256
+
+/**
+ * @struct SparseCSRv
+ * @brief CSR matrix whose values are looked up in a table.
+ *
+ * Same layout as SparseCSR, except that nonzero k has the value
+ * table[value_ind[k]].
+ */
+typedef struct {
+    int rows;                   /**< Number of rows in the matrix. */
+    int cols;                   /**< Number of columns in the matrix. */
+    int nnz;                    /**< Number of non-zero elements in the matrix. */
+    int *row_ptr;               /**< Row pointer array of size 'rows + 1'. */
+    int *col_ind;               /**< Column index array of size 'nnz'. */
+    unsigned char *value_ind;   /**< Index into table of every nonzero, size 'nnz'. */
+    int n_values;               /**< Number of distinct values, at most CSRV_MAX_VALUES. */
+    double *table;              /**< Distinct values in ascending order, size 'n_values'. */
+} SparseCSRv;
+
+/**
+ * @brief Count the distinct values of a CSR matrix.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @return Number of distinct values (compared with ==) among the nonzeros.
+ */
+int count_values_csr(const SparseCSR *matrix);
+
+/**
+ * @brief Create a value-indexed copy of a CSR matrix.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ * @return Pointer to the newly allocated SparseCSRv, or NULL if the matrix has more
+ *         than CSRV_MAX_VALUES distinct values.
+ * @note The values are stored exactly, so spmv_csrv() gives bitwise the same result
+ *       as the reference spmv_csr() on the original matrix.
+ * @note The caller is responsible for freeing the allocated memory using freeSparseCSRv().
+ */
+SparseCSRv* createSparseCSRv(const SparseCSR *matrix);
+
+/**
+ * @brief Free the memory allocated for a SparseCSRv matrix.
+ * @param matrix Pointer to the SparseCSRv structure to free.
+ */
+void freeSparseCSRv(SparseCSRv *matrix);
+
+/**
+ * @brief Sparse matrix-vector multiplication (y = A*x) gathering the values from the table.
+ *
+ * The table stays in L1, so each nonzero streams 5 bytes (column and value index)
+ * instead of 12. Rows are distributed over the OpenMP threads and summed in CSR
+ * order.
+ *
+ * @param matrix Pointer to the SparseCSRv matrix.
+ * @param x Input vector.
+ * @param y Output vector (result).
+ */
+void spmv_csrv(const SparseCSRv *matrix, const double *x, double *y);
+
+# endif
@@ -0,0 +1,91 @@
+/**
+ * @file fastpoisson.h
+ * @brief Header file for the fast Poisson solver with capacitance correction.
+ *
+ * The 5-point Dirichlet operator assembled by assemble_Matrix_Dirichlet() lives on an
+ * irregular set of active points inside the rectangle of the grid. On the whole
+ * rectangle the same stencil is diagonalized by the two-dimensional discrete sine
+ * transform (DST-I), so it can be inverted in O(n log n) with FFTs. The irregular
+ * region is handled by the capacitance matrix method: unknown point sources are
+ * placed on the boundary points (region > 1) and chosen so that the rectangle
+ * solution takes the prescribed boundary values there. The symmetric positive
+ * definite capacitance matrix is formed from the Green's function of the rectangle
+ * and factored once, so every solve costs two fast solves and no iteration; for very
+ * long boundaries it is instead solved matrix-free by CG, one fast solve per iteration.
+ * @see fastpoisson.c, poisson2d.h
+ * @author Li Zhijun
+ * @date 2025-12-14
+ */
+# ifndef FASTPOISSON_H
+# define FASTPOISSON_H
+# include <complex.h>
+# include "grid.h"
+
+/**
+ * @struct DSTPlan
+ * @brief Precomputed data of a DST-I of length n, computed by a mixed-radix FFT of length 2(n + 1).
+ */
+typedef struct {
+    int n;                  /**< Transform length. */
+    int m;                  /**< FFT length, 2 * (n + 1). */
+    int max_factor;         /**< Largest prime factor of m. */
+    double complex *twiddle;/**< exp(-2 pi i k / m), k = 0 .. m-1. */
+    double complex *in;     /**< FFT input buffer of length m. */
+    double complex *out;    /**< FFT output buffer of length m. */
+    double complex *tmp;    /**< Butterfly buffer of length max_factor. */
+} DSTPlan;
+
+/**
+ * @struct FastPoisson
+ * @brief Fast solver for the Dirichlet problem on the active region of a Grid2D.
+ */
+typedef struct {
+    Grid2D *grid;           /**< Grid the solver was built for (not owned). */
+    int nx, ny;             /**< Transform rectangle size: the grid padded to FFT-friendly lengths. */
+    DSTPlan *plan_x;        /**< DST along x (length nx). */
+    DSTPlan *plan_y;        /**< DST along y (length ny). */
+    double *inv_eig;        /**< Scaled inverse eigenvalues of the rectangle operator, nx * ny. */
+    int n_bnd;              /**< Number of boundary (capacitance) points. */
+    int *bnd;               /**< Active indices of the boundary points. */
+    double *cap;            /**< Cholesky factor of the capacitance matrix (n_bnd^2), or NULL to use CG. */
+    int n_iter;             /**< Capacitance CG iterations used by the last solve. */
+    double *u;              /**< Rectangle solution, nx * ny. */
+    double *w;              /**< Rectangle work array, nx * ny. */
+    double *r, *p, *q;      /**< Capacitance CG vectors of length n_bnd. */
+} FastPoisson;
+
+/**
+ * @brief Build the fast Poisson solver for a grid.
+ *
+ * Forms and factors the capacitance matrix in O(n_bnd^2 nx + n_bnd^3) operations, so
+ * the solver should be created once and reused for all right-hand sides.
+ * @param grid Pointer to the grid structure with mapping relationships established by initialize_Grid().
+ *             Every interior point (region == 1) must have its four neighbours active, as
+ *             assumed by assemble_Matrix_Dirichlet().
+ * @return Pointer to the solver.
+ * @note The caller is responsible for freeing it using free_Fast_Poisson().
+ */
+FastPoisson* create_Fast_Poisson(Grid2D *grid);
+
+/**
+ * @brief Solve the system assembled by assemble_Matrix_Dirichlet() / assemble_RHS_Dirichlet().
+ *
+ * Costs two fast solves with the factored capacitance matrix. Otherwise the capacitance
+ * system is solved by CG at one fast solve per iteration; the iteration count is stored
+ * in solver->n_iter (0 for the direct correction).
+ *
+ * @param solver Pointer to the solver.
+ * @param b Right-hand side on the active points (h^2 f on interior points, boundary values otherwise).
+ * @param x Solution on the active points.
+ * @param max_iter Maximum number of capacitance CG iterations (unused by the direct correction).
+ * @param tol Relative residual tolerance of the capacitance system (unused by the direct correction).
+ */
+void solve_Fast_Poisson(FastPoisson *solver, const double *b, double *x, int max_iter, double tol);
+
+/**
+ * @brief Free the fast Poisson solver.
+ * @param solver Pointer to the solver to free.
+ */
+void free_Fast_Poisson(FastPoisson *solver);
+
+# endif
@@ -11,14 +11,39 @@
  */
 # ifndef GRID_H
 # define GRID_H
+# include <stddef.h>
 
 typedef int (*region_divider_func)(double, double, double, double);
 
+typedef void (*region_line_divider_func)(double, const double *, int, double, double, unsigned char *);
+
+/**
+ * @brief Slots of the neighbour table: the 5-point stencil neighbours of an active point.
+ */
+enum {
+    GRID_LEFT = 0,  /**< Point (i - 1, j) */
+    GRID_RIGHT = 1, /**< Point (i + 1, j) */
+    GRID_DOWN = 2,  /**< Point (i, j - 1) */
+    GRID_UP = 3,    /**< Point (i, j + 1) */
+    GRID_N_NEIGHBORS = 4
+};
+
+/**
+ * @struct GridSpan
+ * @brief A maximal run of consecutive active points on one grid line.
+ */
+typedef struct {
+    int start;  /**< Grid index of the first point along the line */
+    int length; /**< Number of points in the run */
+    int first;  /**< Active index of the first point */
+} GridSpan;
+
 /**
  * @struct Grid2D
  * @brief Structure to represent a 2D orthogonal grid.
  * 
- * 
+ * The region and id_map arrays are single contiguous allocations with stride ny:
+ * point (i, j) lives at offset i * ny + j. Use grid_region() and grid_id() to read them.
  */
 typedef struct {
     int nx;         /**< Number of grid points in the x direction */
@@ -30,16 +55,52 @@ typedef struct {
 
     double *x;      /**< Array of x-coordinates of grid points */
     double *y;      /**< Array of y-coordinates of grid points */
-    int **region;   /**< Region array indicating active grid points and boundaries */
+    unsigned char *region; /**< Region type of every grid point, nx * ny row-major (i-major) */
 
-    int **id_map;   /**< Mapping from 2D grid points to 1D indices */
+    int *id_map;    /**< Mapping from 2D grid points to 1D indices, nx * ny row-major, -1 if inactive */
     int n_active;   /**< Number of active grid points */
     int n_interior; /**< Number of interior grid points */
 
     int *id_i;      /**< Array of i-coordinates of active points */
     int *id_j;      /**< Array of j-coordinates of active points */
+
+    int *neighbors; /**< GRID_N_NEIGHBORS active indices per active point (-1 if missing), NULL until built */
+
+    int *span_ptr_i;    /**< Spans of line i (fixed i, along j) are span_i[span_ptr_i[i] .. span_ptr_i[i + 1]) */
+    GridSpan *span_i;   /**< Active spans of the lines of fixed i; active indices run first .. first + length - 1 */
+    int *span_ptr_j;    /**< Spans of line j (fixed j, along i) are span_j[span_ptr_j[j] .. span_ptr_j[j + 1]) */
+    GridSpan *span_j;   /**< Active spans of the lines of fixed j; active indices are not consecutive along i */
 } Grid2D;
 
+/**
+ * @brief Offset of grid point (i, j) in the flat region and id_map arrays.
+ */
+static inline size_t grid_index(const Grid2D *grid, int i, int j) {
+    return (size_t)i * grid->ny + j;
+}
+
+/**
+ * @brief Region type of grid point (i, j): 0 exterior, 1 interior, >1 boundary types.
+ */
+static inline int grid_region(const Grid2D *grid, int i, int j) {
+    return grid->region[grid_index(grid, i, j)];
+}
+
+/**
+ * @brief Active index of grid point (i, j), -1 for exterior points.
+ */
+static inline int grid_id(const Grid2D *grid, int i, int j) {
+    return grid->id_map[grid_index(grid, i, j)];
+}
+
+/**
+ * @brief Neighbour table row of active point k, indexed by GRID_LEFT, GRID_RIGHT, GRID_DOWN, GRID_UP.
+ * @note The table must have been built, see build_neighbors_Grid().
+ */
+static inline const int* grid_neighbors(const Grid2D *grid, int k) {
+    return grid->neighbors + (size_t)k * GRID_N_NEIGHBORS;
+}
+
 /**
  * @brief Create new uniform 2D grid points.
  * @param nx Number of points in x direction.
@@ -74,25 +135,167 @@ Grid2D* create_uniform_grid(int nx, int ny, double x0, double x1, double y0, dou
  *      - param hy: Grid spacing in the y direction
  *      - return value: An integer representing the area to which the grid point belongs.
  *      - return value: ==0 -> not calculated; ==1 -> interior point; >1 -> boundarys
+ *      - return value: region types are stored as bytes and must not exceed 255
  * 
+ * @note The neighbour table and the active spans are built as well, see build_neighbors_Grid() and build_spans_Grid().
+ * @note Large grids call region_divider from several OpenMP threads, so it must be thread-safe.
  * @note The caller is responsible for freeing the allocated memory using free_grid().
  * @see free_grid()
+ * @see initialize_Grid_lines()
  */
 Grid2D* initialize_Grid(int nx, int ny, double x0, double x1, double y0, double y1, region_divider_func region_divider);
 
+/**
+ * @brief Create a new 2D grid structure, classifying a whole grid line per divider call.
+ *
+ * Same as initialize_Grid(), but the divider receives all the points of the line of fixed
+ * x at once, so the user function can vectorize over y and the call overhead is paid once
+ * per line.
+ * @param nx Number of points in x direction.
+ * @param ny Number of points in y direction.
+ * @param x0 X-coordinate on the left of the domain.
+ * @param x1 X-coordinate on the right of the domain.
+ * @param y0 Y-coordinate on the bottom of the domain.
+ * @param y1 Y-coordinate on the top of the domain.
+ * @param line_divider Function pointer classifying one grid line.
+ * @par Function signature requirements:
+ * @code
+ * void line_divider(double x, const double *y, int n, double hx, double hy, unsigned char *region)
+ * @endcode
+ *      - param x: X-coordinate of the grid line
+ *      - param y: Y-coordinates of the n points of the line
+ *      - param hx, hy: Grid spacings
+ *      - param region: Output, region[j] as region_divider would return for (x, y[j]), at most 255
+ *
+ * @note Large grids call line_divider from several OpenMP threads, so it must be thread-safe.
+ * @note The caller is responsible for freeing the allocated memory using free_grid().
+ * @see initialize_Grid()
+ */
+Grid2D* initialize_Grid_lines(int nx, int ny, double x0, double x1, double y0, double y1, region_line_divider_func line_divider);
+
+/**
+ * @brief Number the active points of a grid whose region array has been filled.
+ *
+ * Sets n_active, n_interior, id_map, id_i and id_j from grid->region, numbering the
+ * active points i-major, and rebuilds the neighbour table and the active spans.
+ * initialize_Grid() and initialize_Grid_lines() call it after classification; it is
+ * exposed for grids whose region array is filled by other means, e.g. a geometry.
+ * @param grid Pointer to a grid created by create_uniform_grid() with grid->region filled.
+ */
+void index_Grid(Grid2D *grid);
+
+/**
+ * @brief Build the neighbour table of the active points, if not built yet.
+ *
+ * Stores the active indices of the left, right, down and up neighbours of every active
+ * point in grid->neighbors, -1 where the neighbour is exterior or outside the grid.
+ * Assemblers and stencil kernels then stream through the table instead of looking up
+ * four scattered id_map entries per point.
+ *
+ * @param grid Pointer to the grid structure with mapping relationships established.
+ * @return The neighbour table, owned by the grid.
+ */
+const int* build_neighbors_Grid(Grid2D *grid);
+
+/**
+ * @brief Build the run-length description of the active points, if not built yet.
+ *
+ * Every line of fixed i and every line of fixed j is split into its maximal runs of
+ * active points. Since the active points are numbered i-major, a run of line i holds
+ * the active indices first .. first + length - 1, so gathers and scatters between grid
+ * arrays and active vectors become unit stride copies without a region test per point.
+ *
+ * @param grid Pointer to the grid structure with mapping relationships established.
+ */
+void build_spans_Grid(Grid2D *grid);
+
+/**
+ * @brief Compute a nested dissection ordering of the active points from the grid geometry.
+ *
+ * The bounding box is recursively cut along its longer side by a grid line; the
+ * points of both halves are numbered first and the separator line last. Used as
+ * the fill-reducing ordering of sparse direct factorizations, it keeps the fill of
+ * the 5-point operators at O(N log N).
+ *
+ * @param grid Pointer to the grid structure with mapping relationships established by initialize_Grid().
+ * @param perm Output array of length grid->n_active: perm[k] is the active index eliminated k-th.
+ * @see createSparseLDL()
+ */
+void nested_dissection_Grid(Grid2D *grid, int *perm);
+
+/**
+ * @brief Partition the active points into overlapping strips.
+ *
+ * The grid is cut across its longer side into n_parts strips holding about the same
+ * number of active points; every point is owned by exactly one strip. Strip s is then
+ * widened by overlap grid lines on each side, so neighbouring strips share
+ * 2 * overlap lines. Used as the subdomains of Schwarz preconditioners.
+ *
+ * @param grid Pointer to the grid structure with mapping relationships established by initialize_Grid().
+ * @param n_parts Number of strips.
+ * @param overlap Number of grid lines every strip extends into its neighbours.
+ * @param owner Output array of length grid->n_active: strip owning every active point.
+ * @param part_ptr Output array of length n_parts + 1: start of every strip in the returned array.
+ * @return Active indices of the overlapping strips, strip by strip in grid-line order.
+ * @note The caller is responsible for freeing the returned array.
+ * @see createSchwarzPrecond()
+ */
+int* strip_partition_Grid(Grid2D *grid, int n_parts, int overlap, int *owner, int *part_ptr);
+
+/**
+ * @brief Create an nx x ny array of grid point values.
+ *
+ * The values are one contiguous row-major block, array[0][0 .. nx * ny); array[i] points at row i.
+ * @param grid Pointer to the grid structure.
+ * @return The array of row pointers.
+ * @note The caller is responsible for freeing the array using free_grid_2D_array().
+ */
 double **create_grid_2D_array(Grid2D *grid);
 
+/**
+ * @brief Free an array created by create_grid_2D_array().
+ */
 void* free_grid_2D_array(double** array, Grid2D *grid);
 
 /**
  * @brief Remap the data in the form of column vectors to the grid points.
+ *
+ * Nothing is allocated: the active spans are copied into the caller's array line by line,
+ * in parallel on large grids, so the function can be called every output step.
  * @param grid Pointer to the grid structure with mapping relationships established by initalize_Grid().
  * @param data_indices The data in the form of column vectors.
+ * @param data_points Output array created by create_grid_2D_array(); exterior points are set to 0.
  * 
- * @see initialize_Grid()
+ * @see initialize_Grid(), read_points_to_indices()
  */
 void read_indices_to_points(Grid2D *grid, double* data_indices, double** data_points);
 
+/**
+ * @brief Collect the values of the active grid points into a column vector.
+ *
+ * The inverse of read_indices_to_points(), e.g. to read an initial condition given on the grid.
+ * @param grid Pointer to the grid structure with mapping relationships established by initalize_Grid().
+ * @param data_points Array of nx rows of ny values; exterior points are ignored.
+ * @param data_indices Output column vector of length grid->n_active.
+ */
+void read_points_to_indices(Grid2D *grid, double **data_points, double *data_indices);
+
+/**
+ * @brief Same as read_indices_to_points() for a flat row-major array of nx * ny values.
+ * @param grid Pointer to the grid structure with mapping relationships established by initalize_Grid().
+ * @param data_indices The data in the form of column vectors.
+ * @param data_array Output array, point (i, j) at grid_index(grid, i, j); exterior points are set to 0.
+ */
+void read_indices_to_array(Grid2D *grid, const double *data_indices, double *data_array);
+
+/**
+ * @brief Same as read_points_to_indices() for a flat row-major array of nx * ny values.
+ * @param grid Pointer to the grid structure with mapping relationships established by initalize_Grid().
+ * @param data_array Array with point (i, j) at grid_index(grid, i, j); exterior points are ignored.
+ * @param data_indices Output column vector of length grid->n_active.
+ */
+void read_array_to_indices(Grid2D *grid, const double *data_array, double *data_indices);
+
 /**
  * @brief Free the memory allocated for a grid structure.
  * @param grid Pointer to the grid structure to free.
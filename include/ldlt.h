@@ -0,0 +1,73 @@
+/**
+ * @file ldlt.h
+ * @brief Header file for the sparse direct LDL^T factorization.
+ *
+ * This header file declares a sparse LDL^T factorization for symmetric CSR
+ * matrices under a fill-reducing permutation (e.g. nested_dissection_Grid()).
+ * The factor is computed once and reused by cheap forward/backward solves,
+ * which suits implicit time-stepping with a fixed time-step.
+ * @see ldlt.c, grid.h
+ * @author Li Zhijun
+ * @date 2025-12-12
+ */
+# ifndef LDLT_H
+# define LDLT_H
+# include "csr.h"
+
+/**
+ * @struct SparseLDL
+ * @brief Sparse LDL^T factorization P A P^T = L D L^T of the coupled rows of a matrix.
+ *
+ * Rows that only hold their diagonal entry (Dirichlet rows) are not factored:
+ * they are solved directly and their columns are moved to the right-hand side,
+ * so only the symmetric coupled block is factored. L is unit lower triangular
+ * and stored by columns (CSC).
+ */
+typedef struct {
+    const SparseCSR *matrix;    /**< Factored matrix, used to eliminate the Dirichlet rows. */
+    int n;                      /**< Number of factored (coupled) rows. */
+    int *perm;                  /**< perm[k]: matrix row eliminated at step k, size n. */
+    int *iperm;                 /**< iperm[i]: step of matrix row i, -1 for Dirichlet rows. */
+    int *parent;                /**< Elimination tree, size n. */
+    int *Lp;                    /**< Column pointers of L, size n + 1. */
+    int *Li;                    /**< Row indices of L, size Lp[n]. */
+    double *Lx;                 /**< Values of L, size Lp[n]. */
+    double *D;                  /**< Diagonal D, size n. */
+    double *work;               /**< Work vector of length matrix->rows. */
+} SparseLDL;
+
+/**
+ * @brief Compute the symbolic and numeric LDL^T factorization of a symmetric matrix.
+ * @param matrix Pointer to the SparseCSR matrix (A), symmetric on its coupled rows.
+ *               It must outlive the factorization.
+ * @param perm Fill-reducing ordering of the rows of A (perm[k] = row eliminated k-th),
+ *             or NULL for the natural ordering.
+ * @return Pointer to the factorization, or NULL if a zero pivot is met.
+ * @note The caller is responsible for freeing it using freeSparseLDL().
+ * @see nested_dissection_Grid()
+ */
+SparseLDL* createSparseLDL(const SparseCSR *matrix, const int *perm);
+
+/**
+ * @brief Recompute the numeric factorization for new values on the same pattern.
+ * @param ldl Pointer to the factorization, updated in place.
+ * @param matrix Matrix with the same pattern as the one originally factored.
+ * @return 0 on success, -1 if a zero pivot is met.
+ */
+int refactorSparseLDL(SparseLDL *ldl, const SparseCSR *matrix);
+
+/**
+ * @brief Solve Ax = b with a computed factorization.
+ * @param ldl Pointer to the factorization.
+ * @param b Right-hand side vector.
+ * @param x Solution vector (may alias b).
+ */
+void solveSparseLDL(const SparseLDL *ldl, const double *b, double *x);
+
+/**
+ * @brief Free a factorization (not the matrix).
+ * @param ldl Pointer to the factorization to free.
+ */
+void freeSparseLDL(SparseLDL *ldl);
+
+# endif
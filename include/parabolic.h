@@ -30,6 +30,22 @@ typedef double (*parabolic_source_term)(double x, double y, double t, double hx,
  */
 typedef double (*parabolic_Dirichlet_boundary)(double x, double y, double t, int boundary_type);
 
+/**
+ * @struct SolutionHistory
+ * @brief Ring buffer of the last solutions of a time loop.
+ *
+ * Used to form polynomial extrapolations of the next solution as the initial
+ * guess of an implicit solve, which is far closer than the previous solution
+ * (error O(tau^order) instead of O(tau)).
+ */
+typedef struct {
+    int n;          /**< Length of the stored vectors. */
+    int order;      /**< Maximum number of stored solutions. */
+    int count;      /**< Number of solutions currently stored. */
+    int head;       /**< Slot of the most recent solution. */
+    double *data;   /**< Storage of order * n doubles. */
+} SolutionHistory;
+
 /**
  * @brief Assemble the system matrix for an explicit parabolic time-step.
  *
@@ -43,6 +59,22 @@ typedef double (*parabolic_Dirichlet_boundary)(double x, double y, double t, int
  */
 SparseCSR* assemble_Matrix_Parabolic_Explicit(Grid2D* grid, double tau);
 
+/**
+ * @brief Estimate the largest stable time-step of the explicit scheme.
+ *
+ * Estimates the largest eigenvalue of the (negated) discrete Laplacian on the
+ * interior points with Lanczos_eig_bounds_csr() and returns
+ * `safety * 2 / lambda_max`, which replaces the hand-derived bound
+ * `hx^2 hy^2 / (2 (hx^2 + hy^2))`.
+ *
+ * @param grid Pointer to the Grid2D structure describing the mesh and indexing.
+ * @param safety Safety factor in (0, 1] applied to the stability limit.
+ * @return Estimated stable time-step size.
+ * @note Time-steps above the hand-derived bound are stable but no longer
+ *       monotone (the centre coefficient becomes negative).
+ */
+double estimate_stable_tau_Parabolic_Explicit(Grid2D* grid, double safety);
+
 /**
  * @brief Assemble the right-hand side vector for a parabolic time step.
  *
@@ -59,6 +91,27 @@ SparseCSR* assemble_Matrix_Parabolic_Explicit(Grid2D* grid, double tau);
  */
 void assemble_RHS_Parabolic(Grid2D* grid, parabolic_source_term f, parabolic_Dirichlet_boundary compute_boundary_value, double *b, double t, double tau);
 
+/**
+ * @brief Time-step update u_out = A * u + b(t, tau).
+ *
+ * Fuses the product with the step operator and the right-hand side of
+ * assemble_RHS_Parabolic() in spmv_axpby_term_csr(): every row is finished as it is
+ * written, with the kernel selected by tune_spmv_csr() when the matrix has been tuned,
+ * so u_out is written once. For the explicit scheme u_out is the new solution; for ADI
+ * it is the right-hand side of the implicit half-step.
+ *
+ * @param grid Pointer to grid structure.
+ * @param matrix Step operator (e.g. from assemble_Matrix_Parabolic_Explicit()).
+ * @param f Source term callback.
+ * @param compute_boundary_value Dirichlet boundary callback.
+ * @param u Current solution (must not alias u_out).
+ * @param u_out Pre-allocated array of length `grid->n_active`.
+ * @param t Time at the end of the step.
+ * @param tau Time-step size.
+ * @note On large grids the callbacks are called from several OpenMP threads.
+ */
+void step_Parabolic(Grid2D* grid, const SparseCSR *matrix, parabolic_source_term f, parabolic_Dirichlet_boundary compute_boundary_value, const double *u, double *u_out, double t, double tau);
+
 /**
  * @brief Assemble ADI operator matrices used by the Peaceman–Rachford ADI method.
  *
@@ -72,4 +125,39 @@ void assemble_RHS_Parabolic(Grid2D* grid, parabolic_source_term f, parabolic_Dir
  */
 SparseCSR** assemble_Matrix_Parabolic_ADI(Grid2D* grid, double tau);
 
+/**
+ * @brief Create an empty solution history.
+ *
+ * @param n Length of the solution vectors (usually grid->n_active).
+ * @param order Number of past solutions kept (2 or 3 is typical).
+ * @return Pointer to the new history; free it with `free_Solution_History`.
+ */
+SolutionHistory* create_Solution_History(int n, int order);
+
+/**
+ * @brief Record the solution of the latest time-step.
+ *
+ * @param history Pointer to the history.
+ * @param u Solution vector of length `history->n`.
+ */
+void push_Solution_History(SolutionHistory *history, const double *u);
+
+/**
+ * @brief Extrapolate the stored solutions to the next (equally spaced) time-step.
+ *
+ * Writes the value of the interpolating polynomial through the stored
+ * solutions into `guess`; does nothing when the history is empty.
+ *
+ * @param history Pointer to the history.
+ * @param guess Output vector of length `history->n`.
+ */
+void extrapolate_Solution_History(const SolutionHistory *history, double *guess);
+
+/**
+ * @brief Free the memory allocated for a solution history.
+ *
+ * @param history Pointer to the history to free.
+ */
+void free_Solution_History(SolutionHistory *history);
+
 #endif
\ No newline at end of file
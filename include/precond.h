@@ -0,0 +1,212 @@
+/**
+ * @file precond.h
+ * @brief Header file for preconditioners and level-scheduled triangular solves.
+ *
+ * This header file declares level schedules for running sparse triangular
+ * solves in parallel, and the preconditioners built on top of them:
+ * incomplete LU with zero fill (ILU(0)) and symmetric SOR (SSOR, which is
+ * symmetric Gauss-Seidel for omega = 1), and the overlapping additive Schwarz
+ * domain-decomposition preconditioner with exact local solves and an optional
+ * coarse space. Every preconditioner provides an apply function matching
+ * `precond_func`, so it can be passed to PCG_csr().
+ * @see precond.c, csr.h
+ * @author Li Zhijun
+ * @date 2025-12-10
+ */
+# ifndef PRECOND_H
+# define PRECOND_H
+# include "csr.h"
+# include "band.h"
+
+/**
+ * @struct LevelSchedule
+ * @brief Grouping of the rows of a triangular solve into independent levels.
+ *
+ * A row belongs to level 1 + (highest level among the rows it depends on), so all
+ * rows of one level can be solved concurrently once the previous levels are done.
+ * For the 5-point stencil in natural ordering the levels are the grid anti-diagonals.
+ */
+typedef struct {
+    int n_levels;       /**< Number of levels. */
+    int *level_ptr;     /**< Start of every level in level_rows, size n_levels + 1. */
+    int *level_rows;    /**< Rows ordered by level. */
+} LevelSchedule;
+
+/**
+ * @struct ILU0
+ * @brief Incomplete LU factorization with zero fill-in.
+ *
+ * The factors share the sparsity pattern of A: the strictly lower part holds the
+ * unit lower factor L, the diagonal and upper part hold U.
+ */
+typedef struct {
+    SparseCSR *LU;          /**< Factors L and U in the pattern of A. */
+    SplitCSR *split;        /**< D/L/U view of LU. */
+    LevelSchedule *lower;   /**< Schedule of the forward solve. */
+    LevelSchedule *upper;   /**< Schedule of the backward solve. */
+    double *work;           /**< Work vector of length rows. */
+} ILU0;
+
+/**
+ * @struct SSORPrecond
+ * @brief Symmetric SOR preconditioner M = (D + wL) D^{-1} (D + wU) / (w (2 - w)).
+ */
+typedef struct {
+    SplitCSR *split;        /**< D/L/U view of A. */
+    LevelSchedule *lower;   /**< Schedule of the forward sweep. */
+    LevelSchedule *upper;   /**< Schedule of the backward sweep. */
+    double omega;           /**< Relaxation parameter in (0, 2). */
+    double *work;           /**< Work vector of length rows. */
+} SSORPrecond;
+
+/**
+ * @struct SchwarzPrecond
+ * @brief Two-level overlapping Schwarz preconditioner.
+ *
+ * z = sum_s R_s^T A_s^{-1} R_s r (+ R_0^T A_0^{-1} R_0 r with the coarse space), where
+ * R_s restricts to the rows of subdomain s and A_s = R_s A R_s^T is factored by a
+ * banded LU after RCM reordering. The local solves are independent and run one
+ * subdomain per thread. The restricted variant (RAS) takes every entry of z from the
+ * subdomain owning the row only; it converges faster as a stationary iteration but is
+ * not symmetric. The coarse space has one vector per subdomain, the solution of
+ * A_s phi_s = 1 restricted to the owned rows, and limits the growth of the iteration
+ * count with the number of subdomains. It is added to the local corrections in the
+ * additive variant and applied before them (hybrid) in the restricted one.
+ */
+typedef struct {
+    const SparseCSR *matrix;    /**< Matrix A (not owned). */
+    int n_sub;                  /**< Number of subdomains. */
+    int *sub_ptr;               /**< Start of every subdomain in sub_ind, size n_sub + 1. */
+    int *sub_ind;               /**< Rows of the overlapping subdomains. */
+    int *owner;                 /**< Subdomain owning every row. */
+    int *owner_pos;             /**< Position of every row in the packed local vectors of its owner. */
+    int *map_ptr;               /**< Start of the packed positions of every row in map_pos, size rows + 1. */
+    int *map_pos;               /**< Packed positions of the copies of every row (additive combination). */
+    BandLU **local;             /**< Factorizations of the local matrices A_s. */
+    double *local_r;            /**< Packed local right-hand sides, size sub_ptr[n_sub]. */
+    double *local_z;            /**< Packed local solutions, size sub_ptr[n_sub]. */
+    int restricted;             /**< Nonzero for restricted additive Schwarz. */
+    double *coarse;             /**< Cholesky factor of A_0 (n_sub x n_sub), or NULL without coarse space. */
+    double *coarse_r;           /**< Coarse vector of length n_sub. */
+    double *phi;                /**< Coarse basis: phi[i] is the weight of row i in the vector of its owner. */
+    double *work;               /**< Work vector of length rows. */
+} SchwarzPrecond;
+
+/**
+ * @brief Build the level schedule of a triangular solve.
+ * @param split D/L/U view of the matrix.
+ * @param upper 0 for the forward solve with D + L, 1 for the backward solve with D + U.
+ * @return Pointer to the newly allocated schedule.
+ * @note The caller is responsible for freeing it using freeLevelSchedule().
+ */
+LevelSchedule* createLevelSchedule(const SplitCSR *split, int upper);
+
+/**
+ * @brief Free a level schedule.
+ * @param schedule Pointer to the schedule to free.
+ */
+void freeLevelSchedule(LevelSchedule *schedule);
+
+/**
+ * @brief Parallel forward triangular solve (D + L)x = b over a level schedule.
+ *
+ * Matrices with fewer than CSR_PARALLEL_MIN_NNZ nonzeros are solved serially. Otherwise
+ * the rows of wide levels are split over the OpenMP threads, while runs of levels of a
+ * few hundred rows or less are solved by one thread, so they cost one barrier per run.
+ * @param split D/L/U view of the matrix.
+ * @param schedule Schedule built with createLevelSchedule(split, 0).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (may alias b).
+ */
+void lower_solve_levels_csr(const SplitCSR *split, const LevelSchedule *schedule, const double *b, double *x);
+
+/**
+ * @brief Parallel backward triangular solve (D + U)x = b over a level schedule.
+ *
+ * Threaded like lower_solve_levels_csr().
+ * @param split D/L/U view of the matrix.
+ * @param schedule Schedule built with createLevelSchedule(split, 1).
+ * @param b Right-hand side vector.
+ * @param x Solution vector (may alias b).
+ */
+void upper_solve_levels_csr(const SplitCSR *split, const LevelSchedule *schedule, const double *b, double *x);
+
+/**
+ * @brief Compute the ILU(0) factorization of a CSR matrix.
+ * @param matrix Pointer to the SparseCSR matrix (A), with a nonzero diagonal in every row.
+ * @return Pointer to the newly allocated factorization.
+ * @note The caller is responsible for freeing it using freeILU0().
+ */
+ILU0* createILU0(const SparseCSR *matrix);
+
+/**
+ * @brief Free an ILU(0) factorization.
+ * @param ilu Pointer to the factorization to free.
+ */
+void freeILU0(ILU0 *ilu);
+
+/**
+ * @brief Apply the ILU(0) preconditioner, z = U^{-1} L^{-1} r (matches `precond_func`).
+ * @param ctx Pointer to an ILU0 structure.
+ * @param r Input vector.
+ * @param z Output vector.
+ */
+void apply_ILU0(const void *ctx, const double *r, double *z);
+
+/**
+ * @brief Create an SSOR preconditioner (symmetric Gauss-Seidel for omega = 1).
+ * @param matrix Pointer to the SparseCSR matrix (A); its columns are sorted in place
+ *               and it must outlive the preconditioner.
+ * @param omega Relaxation parameter in (0, 2).
+ * @return Pointer to the newly allocated preconditioner.
+ * @note The caller is responsible for freeing it using freeSSORPrecond().
+ */
+SSORPrecond* createSSORPrecond(SparseCSR *matrix, double omega);
+
+/**
+ * @brief Free an SSOR preconditioner (not the matrix).
+ * @param ssor Pointer to the preconditioner to free.
+ */
+void freeSSORPrecond(SSORPrecond *ssor);
+
+/**
+ * @brief Apply the SSOR preconditioner, z = M^{-1} r (matches `precond_func`).
+ * @param ctx Pointer to an SSORPrecond structure.
+ * @param r Input vector.
+ * @param z Output vector.
+ */
+void apply_SSOR(const void *ctx, const double *r, double *z);
+
+/**
+ * @brief Create an overlapping Schwarz preconditioner from a subdomain partition.
+ *
+ * The local matrices are extracted and factored in parallel.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A); it must outlive the preconditioner.
+ * @param n_sub Number of subdomains.
+ * @param sub_ptr Start of every subdomain in sub_ind, size n_sub + 1.
+ * @param sub_ind Rows of the overlapping subdomains; together they cover all rows.
+ * @param owner Subdomain owning every row, which must belong to that subdomain
+ *              (e.g. from strip_partition_Grid()).
+ * @param restricted Nonzero for restricted additive Schwarz (nonsymmetric, not for PCG_csr()).
+ * @param coarse Nonzero to add the coarse space.
+ * @return Pointer to the newly allocated preconditioner, or NULL if a local factorization fails.
+ * @note The caller is responsible for freeing it using freeSchwarzPrecond().
+ */
+SchwarzPrecond* createSchwarzPrecond(const SparseCSR *matrix, int n_sub, const int *sub_ptr, const int *sub_ind, const int *owner, int restricted, int coarse);
+
+/**
+ * @brief Free a Schwarz preconditioner (not the matrix).
+ * @param schwarz Pointer to the preconditioner to free.
+ */
+void freeSchwarzPrecond(SchwarzPrecond *schwarz);
+
+/**
+ * @brief Apply the Schwarz preconditioner, z = M^{-1} r (matches `precond_func`).
+ * @param ctx Pointer to a SchwarzPrecond structure.
+ * @param r Input vector.
+ * @param z Output vector.
+ */
+void apply_Schwarz(const void *ctx, const double *r, double *z);
+
+# endif
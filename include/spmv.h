@@ -0,0 +1,101 @@
+/**
+ * @file spmv.h
+ * @brief Header file for the SpMV autotuner.
+ *
+ * This header file declares an inspector/executor layer for the sparse matrix-vector
+ * product. The inspector analyses a CSR matrix (row lengths, bandwidth, diagonal
+ * structure), builds the storage formats that fit it, times the candidate kernels on
+ * the matrix itself and keeps the fastest one in an opaque SpMVPlan. The candidates
+ * are:
+ *  - `csr`: the reference row loop of spmv_csr();
+ *  - `csr-unrolled`: row loop accumulating in a register, four entries per step;
+ *  - `sell`: SELL-C-sigma, C rows per chunk stored column by column, rows sorted by
+ *    length within windows of sigma rows, so the inner loop runs across C rows in SIMD;
+ *  - `dia`: diagonal storage for stencil matrices with few distinct offsets (and
+ *    sorted columns);
+ *  - `csr-indexed`: value-indexed CSR (see csrv.h) for matrices with at most 256
+ *    distinct values, 1-byte value indices gathered from a table;
+ *  - `csr-threads`, `sell-threads`, `dia-threads`, `csr-indexed-threads`: OpenMP versions of the above, when
+ *    more than one thread is available.
+ *
+ * Every kernel sums the entries of a row in their CSR order, so all of them give
+ * bitwise the same product as spmv_csr() regardless of the kernel selected or the
+ * number of threads. A plan attached to a matrix with tune_spmv_csr() is used by
+ * spmv_csr() and the fused spmv_axpby_csr(), hence by every solver of the library.
+ * @see spmv.c, csr.h
+ * @author Li Zhijun
+ * @date 2025-12-16
+ */
+# ifndef SPMV_H
+# define SPMV_H
+# include "csr.h"
+
+/**
+ * @brief Inspect a matrix, time the candidate kernels and return the fastest.
+ *
+ * Matrices with fewer than SPMV_TUNE_MIN_NNZ nonzeros are not timed and use `csr`.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A); it must outlive the plan and its
+ *               values must not change while the plan is in use.
+ * @return Pointer to the newly allocated plan.
+ * @note The caller is responsible for freeing it using freeSpMVPlan().
+ */
+SpMVPlan* createSpMVPlan(const SparseCSR *matrix);
+
+/**
+ * @brief Compute y = A * x with the kernel selected by the plan.
+ * @param plan Pointer to the plan.
+ * @param x Input vector.
+ * @param y Output vector.
+ */
+void apply_SpMVPlan(const SpMVPlan *plan, const double *x, double *y);
+
+/**
+ * @brief Fused product y = alpha*A*x + beta*y + b + term with the kernel selected by the plan.
+ *
+ * Every row is finished as soon as its sum is known, so y is read and written once,
+ * with bitwise the result of spmv_axpby_csr() on the untuned matrix. Serial kernels
+ * are threaded over row blocks when a term is given and the matrix has at least
+ * CSR_TERM_PARALLEL_MIN_ROWS rows.
+ * @param plan Pointer to the plan.
+ * @param alpha Scale of the product.
+ * @param x Input vector (must not alias y).
+ * @param beta Scale of the old y; y is not read when beta is 0.
+ * @param y Input/output vector.
+ * @param b Vector added to the result, or NULL.
+ * @param term Row term callback added to the result, or NULL.
+ * @param ctx Context passed to the callback.
+ * @see spmv_axpby_csr(), spmv_axpby_term_csr()
+ */
+void apply_axpby_SpMVPlan(const SpMVPlan *plan, double alpha, const double *x, double beta, double *y, const double *b, csr_row_term term, const void *ctx);
+
+/**
+ * @brief Name of the kernel selected by the plan (e.g. "sell-threads").
+ * @param plan Pointer to the plan.
+ * @return Constant string.
+ */
+const char* name_SpMVPlan(const SpMVPlan *plan);
+
+/**
+ * @brief Free a plan (not the matrix).
+ * @param plan Pointer to the plan to free.
+ */
+void freeSpMVPlan(SpMVPlan *plan);
+
+/**
+ * @brief Tune the SpMV kernel of a matrix and attach the plan to it.
+ *
+ * Afterwards spmv_csr() runs the selected kernel. The plan is freed by freeSparseCSR();
+ * call untune_spmv_csr() (or tune again) before changing the values in place.
+ *
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ */
+void tune_spmv_csr(SparseCSR *matrix);
+
+/**
+ * @brief Detach and free the SpMV plan of a matrix, returning to the reference kernel.
+ * @param matrix Pointer to the SparseCSR matrix (A).
+ */
+void untune_spmv_csr(SparseCSR *matrix);
+
+# endif
@@ -33,6 +33,14 @@ void print_matrix(const double **matrix, int rows, int cols, int ndec);
 
 void print_int_matrix(const int **matrix, int rows, int cols);
 
+/**
+ * @brief Print a contiguous row-major byte matrix, such as the region layout of a grid.
+ * @param matrix Pointer to rows * cols bytes, element (i, j) at i * cols + j.
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ */
+void print_byte_matrix(const unsigned char *matrix, int rows, int cols);
+
 /**
  * @brief Print a SparseCSR matrix in dense format with specified decimal places.
  * @param matrix Pointer to the SparseCSR matrix.
@@ -53,4 +61,10 @@ void write_csv_matrix(const char *filename, double **matrix, int rows, int cols)
 
 void write_csv_int_matrix(const char *filename, int **matrix, int rows, int cols);
 
+/**
+ * @brief Write a contiguous row-major byte matrix to a CSV file.
+ * @see print_byte_matrix()
+ */
+void write_csv_byte_matrix(const char *filename, const unsigned char *matrix, int rows, int cols);
+
 # endif
\ No newline at end of file
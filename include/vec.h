@@ -3,7 +3,22 @@
  * @brief Header file for basic vector operations.
  * 
  * This header file declares functions for basic vector operations such as
- * copying, addition, subtraction, scaling, and dot product.
+ * copying, addition, subtraction, scaling, axpy-style updates, elementwise products,
+ * norms and (multi-)dot products.
+ *
+ * Every operation has a scalar and an AVX2 kernel; the AVX2 one is selected at run
+ * time when the CPU supports it (see vec_simd_name()). No kernel fuses a multiply-add
+ * into an fma, so both give bitwise the same results. Vectors of at least
+ * VEC_PARALLEL_MIN elements (32768) are split over the OpenMP threads. Output vectors
+ * may alias an input vector exactly (e.g. vec_waxpby(x, a, x, b, y, n)), but must not
+ * partially overlap one.
+ *
+ * The reductions (sums and dot products) are bitwise reproducible: the vector is cut
+ * into fixed blocks of VEC_REDUCE_BLOCK elements, every block is summed in a fixed
+ * lane order, and the block sums are combined by a fixed pairwise tree. Blocks are
+ * processed in parallel with OpenMP, and the result does not depend on the number of
+ * threads. The compensated variants additionally carry the rounding errors
+ * (TwoSum/TwoProduct), giving results as accurate as with twice the working precision.
  * @see vec.c
  * @author Li Zhijun
  * @date 2025-10-10
@@ -43,13 +58,134 @@ void vec_sub(double *a, const double *b, int n);
  */
 void vec_scale(double *a, double scalar, int n);
 
+/**
+ * @brief y = y + alpha * x.
+ * @param y Vector to update.
+ * @param alpha Scale of x.
+ * @param x Vector to add.
+ * @param n Number of elements in the vectors.
+ */
+void vec_axpy(double *y, double alpha, const double *x, int n);
+
+/**
+ * @brief y = alpha * x + beta * y.
+ * @param y Vector to update.
+ * @param alpha Scale of x.
+ * @param x Vector to add.
+ * @param beta Scale of y; y is not read when beta is 0.
+ * @param n Number of elements in the vectors.
+ */
+void vec_axpby(double *y, double alpha, const double *x, double beta, int n);
+
+/**
+ * @brief w = alpha * x + beta * y.
+ * @param w Result vector (may be x or y).
+ * @param alpha Scale of x.
+ * @param x First vector.
+ * @param beta Scale of y; y is not read when beta is 0.
+ * @param y Second vector.
+ * @param n Number of elements in the vectors.
+ */
+void vec_waxpby(double *w, double alpha, const double *x, double beta, const double *y, int n);
+
+/**
+ * @brief Elementwise product w = x .* y (e.g. a Jacobi preconditioner with the inverse diagonal).
+ * @param w Result vector (may be x or y).
+ * @param x First vector.
+ * @param y Second vector.
+ * @param n Number of elements in the vectors.
+ */
+void vec_pointwise_mult(double *w, const double *x, const double *y, int n);
+
+/**
+ * @brief Elementwise quotient w = x ./ y.
+ * @param w Result vector (may be x or y).
+ * @param x Numerator vector.
+ * @param y Denominator vector.
+ * @param n Number of elements in the vectors.
+ */
+void vec_pointwise_divide(double *w, const double *x, const double *y, int n);
+
+/**
+ * @brief Name of the kernel set selected at run time ("avx2" or "scalar").
+ * @return Constant string.
+ */
+const char* vec_simd_name(void);
+
+/**
+ * @brief Select the kernel set: AVX2 when the CPU supports it (the default) or the scalar kernels.
+ *
+ * Both give bitwise the same results, so this only matters for timing and testing.
+ * @param enable Nonzero to use AVX2 if available, 0 to force the scalar kernels.
+ * @note Not thread-safe: call it outside parallel regions.
+ */
+void vec_simd_enable(int enable);
+
+/** Elements per block of the reproducible reductions. */
+# define VEC_REDUCE_BLOCK 1024
+
 /**
  * @brief Compute the dot product of vectors a and b.
  * @param a First vector.
  * @param b Second vector.
  * @param n Number of elements in the vectors.
- * @return The dot product (a . b).
+ * @return The dot product (a . b), independent of the number of threads.
  */
 double vec_dot(const double *a, const double *b, int n);
 
+/**
+ * @brief Compute the compensated dot product of vectors a and b.
+ * @param a First vector.
+ * @param b Second vector.
+ * @param n Number of elements in the vectors.
+ * @return The dot product (a . b), independent of the number of threads.
+ */
+double vec_dot_compensated(const double *a, const double *b, int n);
+
+/**
+ * @brief Compute the sum of the elements of a.
+ * @param a Vector to sum.
+ * @param n Number of elements in the vector.
+ * @return The sum, independent of the number of threads.
+ */
+double vec_sum(const double *a, int n);
+
+/**
+ * @brief Compute the compensated sum of the elements of a.
+ * @param a Vector to sum.
+ * @param n Number of elements in the vector.
+ * @return The sum, independent of the number of threads.
+ */
+double vec_sum_compensated(const double *a, int n);
+
+/**
+ * @brief Euclidean norm ||a||_2, bitwise equal to sqrt(vec_dot(a, a, n)).
+ * @param a Vector.
+ * @param n Number of elements in the vector.
+ * @return The 2-norm, independent of the number of threads.
+ */
+double vec_norm2(const double *a, int n);
+
+/**
+ * @brief Maximum norm ||a||_inf.
+ * @param a Vector.
+ * @param n Number of elements in the vector.
+ * @return The largest absolute value of the elements (0 for n = 0).
+ */
+double vec_norm_inf(const double *a, int n);
+
+/**
+ * @brief Several dot products with the same vector in one pass: result[q] = a . b[q].
+ *
+ * Every block of a is combined with all the b[q] while it is in cache, so a is read
+ * once instead of m times. Each result is bitwise equal to vec_dot(a, b[q], n).
+ *
+ * @param a Common vector.
+ * @param b Array of m vectors.
+ * @param m Number of dot products.
+ * @param n Number of elements in the vectors.
+ * @param result Output array of m dot products.
+ */
+void vec_mdot(const double *a, const double *const *b, int m, int n, double *result);
+
 # endif
\ No newline at end of file
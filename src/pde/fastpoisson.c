@@ -0,0 +1,425 @@
+/**
+ * @file fastpoisson.c
+ * @brief Implementation of the fast Poisson solver with capacitance correction.
+ *
+ * This file includes a mixed-radix FFT used to compute the DST-I (two real lines per
+ * complex transform), the fast solver of the 5-point operator on the whole rectangle
+ * of the grid, and the capacitance correction that enforces the Dirichlet values on
+ * the boundary points of the active region: a dense Cholesky factorization of the
+ * capacitance matrix formed from the Green's function of the rectangle, or
+ * matrix-free CG for very long boundaries.
+ * @see fastpoisson.h
+ * @author Li Zhijun
+ * @date 2025-12-14
+ */
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "fastpoisson.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+ * Largest number of boundary points for which the capacitance matrix is formed and factored.
+ * The factor takes 8 n_bnd^2 bytes (128 MiB here) and O(n_bnd^2 nx + n_bnd^3) to set up; at
+ * about 4100 boundary points the dense setup and solve still take half the time of the CG
+ * fallback, whose fast-solve count grows with the boundary length.
+ */
+#define FAST_POISSON_DENSE_LIMIT 4096
+
+static int smallest_factor(int n) {
+    for (int p = 2; p * p <= n; p++) {
+        if (n % p == 0) return p;
+    }
+    return n;
+}
+
+static DSTPlan* create_DST_plan(int n) {
+    DSTPlan *plan = (DSTPlan *)malloc(sizeof(DSTPlan));
+    plan->n = n;
+    plan->m = 2 * (n + 1);
+    plan->max_factor = 1;
+    for (int rest = plan->m; rest > 1; ) {
+        int p = smallest_factor(rest);
+        if (p > plan->max_factor) plan->max_factor = p;
+        rest /= p;
+    }
+    plan->twiddle = (double complex *)malloc(plan->m * sizeof(double complex));
+    for (int k = 0; k < plan->m; k++) {
+        plan->twiddle[k] = cexp(-2.0 * M_PI * I * k / plan->m);
+    }
+    plan->in = (double complex *)malloc(plan->m * sizeof(double complex));
+    plan->out = (double complex *)malloc(plan->m * sizeof(double complex));
+    plan->tmp = (double complex *)malloc(plan->max_factor * sizeof(double complex));
+    return plan;
+}
+
+static void free_DST_plan(DSTPlan *plan) {
+    if (plan) {
+        free(plan->twiddle);
+        free(plan->in);
+        free(plan->out);
+        free(plan->tmp);
+        free(plan);
+    }
+}
+
+/* Smallest n' >= n such that n' + 1 has no prime factor larger than 5. */
+static int fft_friendly_size(int n) {
+    for (int len = n + 1; ; len++) {
+        int rest = len;
+        while (rest % 2 == 0) rest /= 2;
+        while (rest % 3 == 0) rest /= 3;
+        while (rest % 5 == 0) rest /= 5;
+        if (rest == 1) return len - 1;
+    }
+}
+
+/* Decimation-in-time FFT of length n = m / tw_step, reading in[0], in[stride], ... */
+static void fft_recursive(const DSTPlan *plan, const double complex *in, int stride, double complex *out, int n, int tw_step) {
+    if (n == 1) {
+        out[0] = in[0];
+        return;
+    }
+    int p = smallest_factor(n);
+    int len = n / p;
+    for (int r = 0; r < p; r++) {
+        fft_recursive(plan, in + r * stride, stride * p, out + r * len, len, tw_step * p);
+    }
+    // Butterflies: X[k + q len] = sum_r W_n^{r (k + q len)} Y_r[k]
+    const double complex *tw = plan->twiddle;
+    double complex *t = plan->tmp;
+    int root = len * tw_step; // W_p = twiddle[root]
+    for (int k = 0; k < len; k++) {
+        for (int r = 0; r < p; r++) {
+            t[r] = out[r * len + k] * tw[r * k * tw_step];
+        }
+        if (p == 2) {
+            out[k] = t[0] + t[1];
+            out[len + k] = t[0] - t[1];
+            continue;
+        }
+        for (int q = 0; q < p; q++) {
+            double complex sum = t[0];
+            int e = 0;
+            for (int r = 1; r < p; r++) {
+                e += q;
+                if (e >= p) e -= p;
+                sum += t[r] * tw[e * root];
+            }
+            out[q * len + k] = sum;
+        }
+    }
+}
+
+/*
+ * In-place DST-I, x[k] <- sum_j x[j] sin(pi (j+1)(k+1) / (n+1)), of two strided lines
+ * at once: the odd extensions of x and y are packed into the real and imaginary parts
+ * of a single complex FFT. y may be NULL.
+ */
+static void dst_line_pair(const DSTPlan *plan, double *x, double *y, int stride) {
+    int n = plan->n, m = plan->m;
+    double complex *in = plan->in;
+    in[0] = 0.0;
+    in[n + 1] = 0.0;
+    for (int k = 0; k < n; k++) {
+        double complex v = x[k * stride] + (y ? y[k * stride] : 0.0) * I;
+        in[k + 1] = v;
+        in[m - 1 - k] = -v;
+    }
+    fft_recursive(plan, in, 1, plan->out, m, 1);
+    for (int k = 0; k < n; k++) {
+        x[k * stride] = -0.5 * cimag(plan->out[k + 1]);
+        if (y) y[k * stride] = 0.5 * creal(plan->out[k + 1]);
+    }
+}
+
+/* Two-dimensional DST-I of an nx x ny array stored as a[i * ny + j]. */
+static void dst_2d(FastPoisson *solver, double *a) {
+    int nx = solver->nx, ny = solver->ny;
+    for (int i = 0; i < nx; i += 2) {
+        dst_line_pair(solver->plan_y, a + (size_t)i * ny, (i + 1 < nx) ? a + (size_t)(i + 1) * ny : NULL, 1);
+    }
+    for (int j = 0; j < ny; j += 2) {
+        dst_line_pair(solver->plan_x, a + j, (j + 1 < ny) ? a + j + 1 : NULL, ny);
+    }
+}
+
+/* a <- L^{-1} a for the 5-point operator on the rectangle with zero values outside it. */
+static void rectangle_solve(FastPoisson *solver, double *a) {
+    int n = solver->nx * solver->ny;
+    dst_2d(solver, a);
+    for (int k = 0; k < n; k++) {
+        a[k] *= solver->inv_eig[k];
+    }
+    dst_2d(solver, a);
+}
+
+/*
+ * Form the capacitance matrix C = R L^{-1} R^T from the Green's function of the rectangle.
+ * Diagonalizing x by the sine transform leaves, for every mode a, the tridiagonal
+ * operator tridiag(-1, 2 cosh(theta_a), -1) in y, whose inverse is known in closed form:
+ *   T^{-1}(j, j') = sinh((j+1) theta) sinh((ny-j') theta) / (sinh(theta) sinh((ny+1) theta)), j <= j'.
+ * Written with decaying exponentials this costs O(n_bnd^2 nx) and never overflows.
+ */
+static double* capacitance_matrix(FastPoisson *solver) {
+    Grid2D *grid = solver->grid;
+    int nx = solver->nx, ny = solver->ny, m = solver->n_bnd;
+    int n_exp = 2 * (ny + 1) + 1;
+    double *expo = (double *)malloc((size_t)n_exp * nx * sizeof(double)); // expo[d * nx + a] = exp(-d theta_a)
+    double *coef = (double *)malloc(nx * sizeof(double));
+    for (int a = 0; a < nx; a++) {
+        double theta = acosh(2.0 - cos(M_PI * (a + 1) / (nx + 1)));
+        for (int d = 0; d < n_exp; d++) {
+            expo[(size_t)d * nx + a] = exp(-d * theta);
+        }
+        coef[a] = 1.0 / ((nx + 1.0) * sinh(theta) * (1.0 - expo[(size_t)2 * (ny + 1) * nx + a]));
+    }
+    // left[k][a] = coef_a sin_a(i_k) (1 - e^{-2 (j_k+1) theta_a}), right[k][a] = sin_a(i_k) (1 - e^{-2 (ny-j_k) theta_a})
+    double *left = (double *)malloc((size_t)m * nx * sizeof(double));
+    double *right = (double *)malloc((size_t)m * nx * sizeof(double));
+    for (int k = 0; k < m; k++) {
+        int gi = grid->id_i[solver->bnd[k]], gj = grid->id_j[solver->bnd[k]];
+        for (int a = 0; a < nx; a++) {
+            double sa = sin(M_PI * (gi + 1.0) * (a + 1.0) / (nx + 1));
+            left[(size_t)k * nx + a] = coef[a] * sa * (1.0 - expo[(size_t)2 * (gj + 1) * nx + a]);
+            right[(size_t)k * nx + a] = sa * (1.0 - expo[(size_t)2 * (ny - gj) * nx + a]);
+        }
+    }
+    double *C = (double *)malloc((size_t)m * m * sizeof(double));
+    for (int k = 0; k < m; k++) {
+        int jk = grid->id_j[solver->bnd[k]];
+        for (int l = 0; l <= k; l++) {
+            int jl = grid->id_j[solver->bnd[l]];
+            int lo = (jk <= jl) ? k : l, hi = (jk <= jl) ? l : k;
+            int d = (jk <= jl) ? jl - jk : jk - jl;
+            const double *pl = left + (size_t)lo * nx, *pr = right + (size_t)hi * nx, *pe = expo + (size_t)d * nx;
+            double sum = 0.0;
+            for (int a = 0; a < nx; a++) {
+                sum += pl[a] * pr[a] * pe[a];
+            }
+            C[(size_t)k * m + l] = sum;
+            C[(size_t)l * m + k] = sum;
+        }
+    }
+    free(expo);
+    free(coef);
+    free(left);
+    free(right);
+    return C;
+}
+
+/* In-place dense Cholesky factorization, lower triangle of the row-major n x n matrix. */
+static int dense_cholesky(double *C, int n) {
+    for (int j = 0; j < n; j++) {
+        double *cj = C + (size_t)j * n;
+        double d = cj[j];
+        for (int k = 0; k < j; k++) {
+            d -= cj[k] * cj[k];
+        }
+        if (d <= 0.0) return 0;
+        d = sqrt(d);
+        cj[j] = d;
+        for (int i = j + 1; i < n; i++) {
+            double *ci = C + (size_t)i * n;
+            double sum = ci[j];
+            for (int k = 0; k < j; k++) {
+                sum -= ci[k] * cj[k];
+            }
+            ci[j] = sum / d;
+        }
+    }
+    return 1;
+}
+
+/* Solve L L^T x = x with the dense Cholesky factor. */
+static void dense_cholesky_solve(const double *C, int n, double *x) {
+    for (int i = 0; i < n; i++) {
+        const double *ci = C + (size_t)i * n;
+        double sum = x[i];
+        for (int k = 0; k < i; k++) {
+            sum -= ci[k] * x[k];
+        }
+        x[i] = sum / ci[i];
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        double sum = x[i];
+        for (int k = i + 1; k < n; k++) {
+            sum -= C[(size_t)k * n + i] * x[k];
+        }
+        x[i] = sum / C[(size_t)i * n + i];
+    }
+}
+
+/* Copy the active vector v into the rectangle a of column count ny, one active span at a time. */
+static void scatter_active(const Grid2D *grid, int ny, const double *v, double *a) {
+    for (int i = 0; i < grid->nx; i++) {
+        for (int s = grid->span_ptr_i[i]; s < grid->span_ptr_i[i + 1]; s++) {
+            const GridSpan *span = &grid->span_i[s];
+            memcpy(a + (size_t)i * ny + span->start, v + span->first, span->length * sizeof(double));
+        }
+    }
+}
+
+/* Copy the active points of the rectangle a of column count ny into v. */
+static void gather_active(const Grid2D *grid, int ny, const double *a, double *v) {
+    for (int i = 0; i < grid->nx; i++) {
+        for (int s = grid->span_ptr_i[i]; s < grid->span_ptr_i[i + 1]; s++) {
+            const GridSpan *span = &grid->span_i[s];
+            memcpy(v + span->first, a + (size_t)i * ny + span->start, span->length * sizeof(double));
+        }
+    }
+}
+
+FastPoisson* create_Fast_Poisson(Grid2D *grid) {
+    FastPoisson *solver = (FastPoisson *)malloc(sizeof(FastPoisson));
+    // Pad the rectangle to transform lengths with small prime factors only; the extra
+    // points are exterior points and do not change the solution on the active region.
+    int nx = fft_friendly_size(grid->nx), ny = fft_friendly_size(grid->ny);
+    solver->grid = grid;
+    build_spans_Grid(grid);
+    solver->nx = nx;
+    solver->ny = ny;
+    solver->plan_x = create_DST_plan(nx);
+    solver->plan_y = create_DST_plan(ny);
+
+    // The DST-I is its own inverse up to the factor 2 / (n + 1) in each direction
+    double scale = 4.0 / ((nx + 1.0) * (ny + 1.0));
+    solver->inv_eig = (double *)malloc((size_t)nx * ny * sizeof(double));
+    for (int i = 0; i < nx; i++) {
+        double ex = 2.0 - 2.0 * cos(M_PI * (i + 1) / (nx + 1));
+        for (int j = 0; j < ny; j++) {
+            double ey = 2.0 - 2.0 * cos(M_PI * (j + 1) / (ny + 1));
+            solver->inv_eig[(size_t)i * ny + j] = scale / (ex + ey);
+        }
+    }
+
+    solver->n_bnd = grid->n_active - grid->n_interior;
+    solver->bnd = (int *)malloc((solver->n_bnd > 0 ? solver->n_bnd : 1) * sizeof(int));
+    int idx = 0;
+    for (int k = 0; k < grid->n_active; k++) {
+        if (grid_region(grid, grid->id_i[k], grid->id_j[k]) != 1) {
+            solver->bnd[idx++] = k;
+        }
+    }
+    solver->n_bnd = idx;
+    solver->n_iter = 0;
+
+    solver->cap = NULL;
+    if (idx > 0 && idx <= FAST_POISSON_DENSE_LIMIT) {
+        solver->cap = capacitance_matrix(solver);
+        if (!dense_cholesky(solver->cap, idx)) {
+            free(solver->cap);
+            solver->cap = NULL;
+        }
+    }
+
+    solver->u = (double *)malloc((size_t)nx * ny * sizeof(double));
+    solver->w = (double *)malloc((size_t)nx * ny * sizeof(double));
+    solver->r = (double *)malloc((idx > 0 ? idx : 1) * sizeof(double));
+    solver->p = (double *)malloc((idx > 0 ? idx : 1) * sizeof(double));
+    solver->q = (double *)malloc((idx > 0 ? idx : 1) * sizeof(double));
+    return solver;
+}
+
+void solve_Fast_Poisson(FastPoisson *solver, const double *b, double *x, int max_iter, double tol) {
+    Grid2D *grid = solver->grid;
+    int ny = solver->ny;
+    int n = solver->nx * ny;
+    int m = solver->n_bnd;
+    double *u = solver->u, *w = solver->w;
+    double *r = solver->r, *p = solver->p, *q = solver->q;
+    int *bnd = solver->bnd;
+
+    // u0 = L^{-1} f with the source on the interior points only
+    for (int k = 0; k < n; k++) {
+        u[k] = 0.0;
+    }
+    scatter_active(grid, ny, b, u);
+    for (int k = 0; k < m; k++) {
+        u[(size_t)grid->id_i[bnd[k]] * ny + grid->id_j[bnd[k]]] = 0.0;
+    }
+    rectangle_solve(solver, u);
+
+    // Direct correction: sigma = C^{-1} (g - u0|B), u = L^{-1} (f + R^T sigma)
+    if (solver->cap) {
+        for (int k = 0; k < m; k++) {
+            r[k] = b[bnd[k]] - u[(size_t)grid->id_i[bnd[k]] * ny + grid->id_j[bnd[k]]];
+        }
+        dense_cholesky_solve(solver->cap, m, r);
+        for (int k = 0; k < n; k++) {
+            u[k] = 0.0;
+        }
+        scatter_active(grid, ny, b, u);
+        for (int k = 0; k < m; k++) {
+            u[(size_t)grid->id_i[bnd[k]] * ny + grid->id_j[bnd[k]]] = r[k];
+        }
+        rectangle_solve(solver, u);
+        solver->n_iter = 0;
+        gather_active(grid, ny, u, x);
+        return;
+    }
+
+    // Without the factored matrix, CG on the capacitance system C sigma = g - u0|B with C = R L^{-1} R^T; the rectangle
+    // solution is updated alongside, u += alpha L^{-1} R^T p, so no final solve is needed.
+    double rr = 0.0, gg = 0.0;
+    for (int k = 0; k < m; k++) {
+        int gi = grid->id_i[bnd[k]], gj = grid->id_j[bnd[k]];
+        r[k] = b[bnd[k]] - u[(size_t)gi * ny + gj];
+        p[k] = r[k];
+        rr += r[k] * r[k];
+        gg += b[bnd[k]] * b[bnd[k]];
+    }
+    double stop = tol * tol * (gg > 0.0 ? gg : 1.0);
+    int iter = 0;
+    while (iter < max_iter && rr > stop) {
+        for (int k = 0; k < n; k++) {
+            w[k] = 0.0;
+        }
+        for (int k = 0; k < m; k++) {
+            w[(size_t)grid->id_i[bnd[k]] * ny + grid->id_j[bnd[k]]] = p[k];
+        }
+        rectangle_solve(solver, w);
+        double pq = 0.0;
+        for (int k = 0; k < m; k++) {
+            q[k] = w[(size_t)grid->id_i[bnd[k]] * ny + grid->id_j[bnd[k]]];
+            pq += p[k] * q[k];
+        }
+        double alpha = rr / pq;
+        for (int k = 0; k < n; k++) {
+            u[k] += alpha * w[k];
+        }
+        double rr_new = 0.0;
+        for (int k = 0; k < m; k++) {
+            r[k] -= alpha * q[k];
+            rr_new += r[k] * r[k];
+        }
+        double beta = rr_new / rr;
+        for (int k = 0; k < m; k++) {
+            p[k] = r[k] + beta * p[k];
+        }
+        rr = rr_new;
+        iter++;
+    }
+    solver->n_iter = iter;
+
+    gather_active(grid, ny, u, x);
+}
+
+void free_Fast_Poisson(FastPoisson *solver) {
+    if (solver) {
+        free_DST_plan(solver->plan_x);
+        free_DST_plan(solver->plan_y);
+        free(solver->inv_eig);
+        free(solver->bnd);
+        free(solver->cap);
+        free(solver->u);
+        free(solver->w);
+        free(solver->r);
+        free(solver->p);
+        free(solver->q);
+        free(solver);
+    }
+}
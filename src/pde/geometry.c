@@ -0,0 +1,246 @@
+/**
+ * @file geometry.c
+ * @brief Implementation of polygonal domain descriptions and scanline classification.
+ *
+ * Every grid line is intersected with all edges once. Crossings of the edges that are
+ * not parallel to the line follow the half-open rule, an edge owning the scanlines in
+ * (lower end, upper end], so a vertex shared by two edges is counted once; sorted
+ * crossings pair up into the covered intervals. Edges lying on the scanline add their
+ * own interval, which closes the domain along its flat sides.
+ *
+ * @author Li Zhijun
+ * @date 2025-12-20
+ */
+#include <stdlib.h>
+#include <math.h>
+#include "geometry.h"
+
+/* Scanline tolerance relative to the grid spacing. */
+#define GEOMETRY_EPS 1e-9
+
+/* Grids with at least this many points are classified by all OpenMP threads. */
+#define GEOMETRY_PARALLEL_MIN_POINTS 65536
+
+/* Crossing of an edge with a scanline at u, with the slope du/dv of the edge. */
+typedef struct {
+    double u, slope;
+    int tag;
+} ScanCrossing;
+
+/* A covered interval [a, b] of a scanline with the boundary types at both ends. */
+typedef struct {
+    double a, b;
+    int tag_a, tag_b;
+} ScanInterval;
+
+/* A covered interval of a line of fixed y as grid indices: i0 .. ia-1 get tag_a, ib+1 .. i1 tag_b. */
+typedef struct {
+    int i0, ia, ib, i1;
+    unsigned char tag_a, tag_b;
+} RowRange;
+
+Geometry2D* create_Geometry2D(void) {
+    Geometry2D *geometry = (Geometry2D *)malloc(sizeof(Geometry2D));
+    geometry->n_edges = 0;
+    geometry->capacity = 0;
+    geometry->edges = NULL;
+    return geometry;
+}
+
+void add_polygon_Geometry2D(Geometry2D *geometry, int n_vertices, const double *x, const double *y, const int *tags) {
+    if (geometry->n_edges + n_vertices > geometry->capacity) {
+        int capacity = 2 * geometry->capacity > geometry->n_edges + n_vertices ? 2 * geometry->capacity : geometry->n_edges + n_vertices;
+        geometry->edges = (GeometryEdge *)realloc(geometry->edges, capacity * sizeof(GeometryEdge));
+        geometry->capacity = capacity;
+    }
+    GeometryEdge *edges = geometry->edges + geometry->n_edges;
+    for (int k = 0; k < n_vertices; k++) {
+        int next = (k + 1) % n_vertices;
+        edges[k].x0 = x[k];
+        edges[k].y0 = y[k];
+        edges[k].x1 = x[next];
+        edges[k].y1 = y[next];
+        edges[k].tag = tags[k];
+        edges[k].tag0 = tags[(k + n_vertices - 1) % n_vertices];
+        edges[k].tag1 = tags[next];
+    }
+    geometry->n_edges += n_vertices;
+}
+
+/*
+ * Covered intervals of the scanline v = c, with u the coordinate along it: (u, v) = (x, y)
+ * for lines of fixed y and (y, x) for lines of fixed x. cross holds n_edges entries,
+ * intervals 2 * n_edges. Returns the number of intervals, sorted and disjoint.
+ */
+static int scan_line(const Geometry2D *geometry, int along_y, double c, double tol_v, double tol_u,
+                     ScanCrossing *cross, ScanInterval *intervals) {
+    int n_cross = 0, n = 0;
+    for (int e = 0; e < geometry->n_edges; e++) {
+        const GeometryEdge *edge = &geometry->edges[e];
+        double u0 = along_y ? edge->y0 : edge->x0, v0 = along_y ? edge->x0 : edge->y0;
+        double u1 = along_y ? edge->y1 : edge->x1, v1 = along_y ? edge->x1 : edge->y1;
+
+        if (fabs(v1 - v0) <= tol_v) {
+            // Edge on the scanline: covered, its ends take the types of the adjoining edges
+            if (fabs(v0 - c) <= tol_v) {
+                intervals[n].a = u0 < u1 ? u0 : u1;
+                intervals[n].b = u0 < u1 ? u1 : u0;
+                intervals[n].tag_a = u0 < u1 ? edge->tag0 : edge->tag1;
+                intervals[n].tag_b = u0 < u1 ? edge->tag1 : edge->tag0;
+                n++;
+            }
+            continue;
+        }
+
+        double lo = v0 < v1 ? v0 : v1, hi = v0 < v1 ? v1 : v0;
+        if (c > lo + tol_v && c <= hi + tol_v) {
+            ScanCrossing crossing;
+            crossing.slope = (u1 - u0) / (v1 - v0);
+            crossing.u = u0 + (c - v0) * crossing.slope;
+            crossing.tag = edge->tag;
+            // Edges meeting at a vertex on the scanline are ordered as they run just below it
+            int k = n_cross++;
+            while (k > 0 && (cross[k - 1].u > crossing.u + tol_u
+                             || (cross[k - 1].u >= crossing.u - tol_u && cross[k - 1].slope < crossing.slope))) {
+                cross[k] = cross[k - 1];
+                k--;
+            }
+            cross[k] = crossing;
+        }
+    }
+
+    for (int k = 0; k + 1 < n_cross; k += 2) {
+        intervals[n].a = cross[k].u;
+        intervals[n].b = cross[k + 1].u;
+        intervals[n].tag_a = cross[k].tag;
+        intervals[n].tag_b = cross[k + 1].tag;
+        n++;
+    }
+
+    // Sort by left end and merge the intervals that touch
+    for (int k = 1; k < n; k++) {
+        ScanInterval key = intervals[k];
+        int m = k;
+        while (m > 0 && intervals[m - 1].a > key.a) {
+            intervals[m] = intervals[m - 1];
+            m--;
+        }
+        intervals[m] = key;
+    }
+    int n_merged = 0;
+    for (int k = 0; k < n; k++) {
+        if (n_merged > 0 && intervals[k].a <= intervals[n_merged - 1].b + tol_u) {
+            ScanInterval *last = &intervals[n_merged - 1];
+            if (intervals[k].b > last->b) {
+                last->b = intervals[k].b;
+                last->tag_b = intervals[k].tag_b;
+            }
+        } else {
+            intervals[n_merged++] = intervals[k];
+        }
+    }
+    return n_merged;
+}
+
+void classify_Geometry2D(const Geometry2D *geometry, Grid2D *grid) {
+    int nx = grid->nx, ny = grid->ny;
+    double hx = grid->hx, hy = grid->hy;
+    double tol_x = GEOMETRY_EPS * hx, tol_y = GEOMETRY_EPS * hy;
+    int n_edges = geometry->n_edges > 0 ? geometry->n_edges : 1;
+    ScanCrossing *cross = (ScanCrossing *)malloc(n_edges * sizeof(ScanCrossing));
+    ScanInterval *intervals = (ScanInterval *)malloc(2 * n_edges * sizeof(ScanInterval));
+
+    // Lines of fixed y decide which points are active and their types along x. They are turned
+    // into index ranges first, so the region array is then written line by line of fixed x.
+    int *row_ptr = (int *)malloc((ny + 1) * sizeof(int));
+    int capacity = ny > 0 ? ny : 1;
+    RowRange *ranges = (RowRange *)malloc(capacity * sizeof(RowRange));
+    row_ptr[0] = 0;
+    for (int j = 0; j < ny; j++) {
+        int n = scan_line(geometry, 0, grid->y[j], tol_y, tol_x, cross, intervals);
+        if (row_ptr[j] + n > capacity) {
+            capacity = 2 * capacity > row_ptr[j] + n ? 2 * capacity : row_ptr[j] + n;
+            ranges = (RowRange *)realloc(ranges, capacity * sizeof(RowRange));
+        }
+        int next = row_ptr[j];
+        for (int s = 0; s < n; s++) {
+            const ScanInterval *interval = &intervals[s];
+            int i0 = (int)ceil((interval->a - tol_x - grid->x0) / hx);
+            int i1 = (int)floor((interval->b + tol_x - grid->x0) / hx);
+            i0 = i0 > 0 ? i0 : 0;
+            i1 = i1 < nx - 1 ? i1 : nx - 1;
+            if (i0 > i1) continue;
+            // Points before ia are closer than hx to the left end, points after ib to the right end
+            int ia = i0, ib = i1;
+            while (ia <= i1 && grid->x[ia] - interval->a < hx - tol_x) ia++;
+            while (ib >= ia && interval->b - grid->x[ib] < hx - tol_x) ib--;
+            ranges[next].i0 = i0;
+            ranges[next].ia = ia;
+            ranges[next].ib = ib;
+            ranges[next].i1 = i1;
+            ranges[next].tag_a = (unsigned char)interval->tag_a;
+            ranges[next].tag_b = (unsigned char)interval->tag_b;
+            next++;
+        }
+        row_ptr[j + 1] = next;
+    }
+    free(cross);
+    free(intervals);
+
+    #pragma omp parallel if ((size_t)nx * ny >= GEOMETRY_PARALLEL_MIN_POINTS)
+    {
+        ScanCrossing *line_cross = (ScanCrossing *)malloc(n_edges * sizeof(ScanCrossing));
+        ScanInterval *line_intervals = (ScanInterval *)malloc(2 * n_edges * sizeof(ScanInterval));
+
+        #pragma omp for schedule(static)
+        for (int i = 0; i < nx; i++) {
+            unsigned char *region = grid->region + grid_index(grid, i, 0);
+            for (int j = 0; j < ny; j++) {
+                unsigned char type = 0;
+                for (int r = row_ptr[j]; r < row_ptr[j + 1]; r++) {
+                    const RowRange *range = &ranges[r];
+                    if (i >= range->i0 && i <= range->i1) {
+                        type = i < range->ia ? range->tag_a : (i > range->ib ? range->tag_b : 1);
+                        break;
+                    }
+                }
+                region[j] = type;
+            }
+
+            // The line itself gives the remaining interior points their types along y
+            int n = scan_line(geometry, 1, grid->x[i], tol_x, tol_y, line_cross, line_intervals);
+            for (int s = 0; s < n; s++) {
+                const ScanInterval *interval = &line_intervals[s];
+                int j0 = (int)ceil((interval->a - tol_y - grid->y0) / hy);
+                int j1 = (int)floor((interval->b + tol_y - grid->y0) / hy);
+                j0 = j0 > 0 ? j0 : 0;
+                j1 = j1 < ny - 1 ? j1 : ny - 1;
+                for (int j = j0; j <= j1 && grid->y[j] - interval->a < hy - tol_y; j++) {
+                    if (region[j] == 1) region[j] = (unsigned char)interval->tag_a;
+                }
+                for (int j = j1; j >= j0 && interval->b - grid->y[j] < hy - tol_y; j--) {
+                    if (region[j] == 1) region[j] = (unsigned char)interval->tag_b;
+                }
+            }
+        }
+
+        free(line_cross);
+        free(line_intervals);
+    }
+    free(row_ptr);
+    free(ranges);
+}
+
+Grid2D* initialize_Grid_geometry(int nx, int ny, double x0, double x1, double y0, double y1, const Geometry2D *geometry) {
+    Grid2D *grid = create_uniform_grid(nx, ny, x0, x1, y0, y1);
+    classify_Geometry2D(geometry, grid);
+    index_Grid(grid);
+    return grid;
+}
+
+void free_Geometry2D(Geometry2D *geometry) {
+    if (geometry) {
+        free(geometry->edges);
+        free(geometry);
+    }
+}
@@ -3,15 +3,25 @@
  * @brief Implementation of uniform grid operations.
  * 
  * This file includes functions for creating, freeing, initializing, and
- * remapping data in form of column vectors to data in form of matrix.
+ * remapping data in form of column vectors to data in form of matrix, as well
+ * as a geometric nested dissection ordering of the active points. Large grids
+ * are classified and indexed line by line on all OpenMP threads.
  * 
  * @author Li Zhijun
  * @date 2025-10-21
  */
 #include <stdlib.h>
+#include <string.h>
 #include "grid.h"
 
-Grid2D* create_uniform_grid(int nx, int ny, double x0, double x1, double y0, double y1) {
+/* Boxes with at most this many grid points are numbered directly. */
+#define NESTED_DISSECTION_LEAF_SIZE 64
+
+/* Grids with at least this many points are classified and indexed by all OpenMP threads. */
+#define GRID_PARALLEL_MIN_POINTS 65536
+
+/* Allocate a uniform grid with the coordinates set and the region and id_map arrays left uninitialized. */
+static Grid2D* allocate_uniform_grid(int nx, int ny, double x0, double x1, double y0, double y1) {
     Grid2D *grid = (Grid2D *)malloc(sizeof(Grid2D));
     grid->nx = nx;
     grid->ny = ny;
@@ -32,109 +42,375 @@ Grid2D* create_uniform_grid(int nx, int ny, double x0, double x1, double y0, dou
         grid->y[j] = y0 + j * grid->hy;
     }
 
-    grid->region = (int **)malloc(nx * sizeof(int *));
+    size_t n_points = (size_t)nx * ny;
+    grid->region = (unsigned char *)malloc((n_points > 0 ? n_points : 1) * sizeof(unsigned char));
+    grid->id_map = (int *)malloc((n_points > 0 ? n_points : 1) * sizeof(int));
+    grid->n_active = 0;
+    grid->n_interior = 0;
+    grid->id_i = NULL;
+    grid->id_j = NULL;
+    grid->neighbors = NULL;
+    grid->span_ptr_i = NULL;
+    grid->span_i = NULL;
+    grid->span_ptr_j = NULL;
+    grid->span_j = NULL;
+    return grid;
+}
+
+Grid2D* create_uniform_grid(int nx, int ny, double x0, double x1, double y0, double y1) {
+    Grid2D *grid = allocate_uniform_grid(nx, ny, x0, x1, y0, y1);
+    size_t n_points = (size_t)nx * ny;
+    memset(grid->region, 0, n_points * sizeof(unsigned char)); // Default: all points are exterior
+    for (size_t p = 0; p < n_points; p++) {
+        grid->id_map[p] = -1; // Initialize to -1
+    }
+    return grid;
+}
+
+/* Classify every grid line i with either divider; lines are independent and classified in parallel. */
+static Grid2D* classify_Grid(Grid2D *grid, region_divider_func region_divider, region_line_divider_func line_divider) {
+    int nx = grid->nx, ny = grid->ny;
+
+    #pragma omp parallel for schedule(static) if ((size_t)nx * ny >= GRID_PARALLEL_MIN_POINTS)
     for (int i = 0; i < nx; i++) {
-        grid->region[i] = (int *)malloc(ny * sizeof(int));
+        unsigned char *region = grid->region + grid_index(grid, i, 0);
+        if (line_divider) {
+            line_divider(grid->x[i], grid->y, ny, grid->hx, grid->hy, region);
+        } else {
+            for (int j = 0; j < ny; j++) {
+                int region_value = region_divider(grid->x[i], grid->y[j], grid->hx, grid->hy);
+                region[j] = region_value > 0 ? (unsigned char)region_value : 0;
+            }
+        }
+    }
+    index_Grid(grid);
+    return grid;
+}
+
+/*
+ * Lines are counted in parallel, and a prefix sum over the per-line active counts gives
+ * every line its first active index, so the numbering matches the serial i-major sweep.
+ */
+void index_Grid(Grid2D *grid) {
+    int nx = grid->nx, ny = grid->ny;
+    int parallel = (size_t)nx * ny >= GRID_PARALLEL_MIN_POINTS;
+    int *line_active = (int *)malloc((nx + 1) * sizeof(int));
+    int n_interior = 0;
+    free(grid->id_i);
+    free(grid->id_j);
+    free(grid->neighbors);
+    free(grid->span_ptr_i);
+    free(grid->span_i);
+    free(grid->span_ptr_j);
+    free(grid->span_j);
+    grid->neighbors = NULL;
+    grid->span_ptr_i = NULL;
+    grid->span_i = NULL;
+    grid->span_ptr_j = NULL;
+    grid->span_j = NULL;
+
+    #pragma omp parallel for schedule(static) reduction(+:n_interior) if (parallel)
+    for (int i = 0; i < nx; i++) {
+        const unsigned char *region = grid->region + grid_index(grid, i, 0);
+        int active = 0;
         for (int j = 0; j < ny; j++) {
-            grid->region[i][j] = 0; // Default: all points are exterior
+            active += region[j] > 0;
+            n_interior += region[j] == 1;
         }
+        line_active[i + 1] = active;
+    }
+
+    line_active[0] = 0;
+    for (int i = 0; i < nx; i++) {
+        line_active[i + 1] += line_active[i];
     }
-    grid->id_map = (int **)malloc(nx * sizeof(int *));
+    grid->n_active = line_active[nx];
+    grid->n_interior = n_interior;
+
+    // Active points are numbered i-major, so the coordinates follow in the same sweep order
+    grid->id_i = (int *)malloc((grid->n_active > 0 ? grid->n_active : 1) * sizeof(int));
+    grid->id_j = (int *)malloc((grid->n_active > 0 ? grid->n_active : 1) * sizeof(int));
+    #pragma omp parallel for schedule(static) if (parallel)
     for (int i = 0; i < nx; i++) {
-        grid->id_map[i] = (int *)malloc(ny * sizeof(int));
+        const unsigned char *region = grid->region + grid_index(grid, i, 0);
+        int *id_map = grid->id_map + grid_index(grid, i, 0);
+        int k = line_active[i];
         for (int j = 0; j < ny; j++) {
-            grid->id_map[i][j] = -1; // Initialize to -1
+            if (region[j] > 0) {
+                id_map[j] = k;
+                grid->id_i[k] = i;
+                grid->id_j[k] = j;
+                k++;
+            } else {
+                id_map[j] = -1;
+            }
         }
     }
+    free(line_active);
 
-    return grid;
+    build_neighbors_Grid(grid);
+    build_spans_Grid(grid);
 }
 
 Grid2D* initialize_Grid(int nx, int ny, double x0, double x1, double y0, double y1, region_divider_func region_divider) {
-    Grid2D *grid = create_uniform_grid(nx, ny, x0, x1, y0, y1);
-    grid->n_active = 0;
-    grid->n_interior = 0;
-    for (int i = 0; i < grid->nx; i++) {
-        for (int j = 0; j < grid->ny; j++) {
-            int region_value = region_divider(grid->x[i], grid->y[j], grid->hx, grid->hy);
-            if (region_value > 0) {
-                grid->region[i][j] = region_value;
-                grid->id_map[i][j] = grid->n_active;
-                grid->n_active++;
-                if (region_value == 1) {
-                    grid->n_interior++;
-                }
-            } else {
-                grid->region[i][j] = 0;
-                grid->id_map[i][j] = -1;
+    Grid2D *grid = allocate_uniform_grid(nx, ny, x0, x1, y0, y1);
+    return classify_Grid(grid, region_divider, NULL);
+}
+
+Grid2D* initialize_Grid_lines(int nx, int ny, double x0, double x1, double y0, double y1, region_line_divider_func line_divider) {
+    Grid2D *grid = allocate_uniform_grid(nx, ny, x0, x1, y0, y1);
+    return classify_Grid(grid, NULL, line_divider);
+}
+
+const int* build_neighbors_Grid(Grid2D *grid) {
+    if (grid->neighbors) return grid->neighbors;
+
+    int nx = grid->nx, ny = grid->ny;
+    size_t n_entries = (size_t)grid->n_active * GRID_N_NEIGHBORS;
+    int *neighbors = (int *)malloc((n_entries > 0 ? n_entries : 1) * sizeof(int));
+    #pragma omp parallel for schedule(static) if ((size_t)nx * ny >= GRID_PARALLEL_MIN_POINTS)
+    for (int k = 0; k < grid->n_active; k++) {
+        int i = grid->id_i[k], j = grid->id_j[k];
+        size_t p = grid_index(grid, i, j);
+        int *row = neighbors + (size_t)k * GRID_N_NEIGHBORS;
+        row[GRID_LEFT] = i > 0 ? grid->id_map[p - ny] : -1;
+        row[GRID_RIGHT] = i < nx - 1 ? grid->id_map[p + ny] : -1;
+        row[GRID_DOWN] = j > 0 ? grid->id_map[p - 1] : -1;
+        row[GRID_UP] = j < ny - 1 ? grid->id_map[p + 1] : -1;
+    }
+    grid->neighbors = neighbors;
+    return neighbors;
+}
+
+/* Split n_lines lines of n_along points, point (l, c) at offset l * line_stride + c * point_stride, into active runs. */
+static GridSpan* line_spans(const Grid2D *grid, int n_lines, int n_along, size_t line_stride, size_t point_stride, int *span_ptr) {
+    int parallel = (size_t)n_lines * n_along >= GRID_PARALLEL_MIN_POINTS;
+    #pragma omp parallel for schedule(static) if (parallel)
+    for (int l = 0; l < n_lines; l++) {
+        int count = 0, prev = 0;
+        for (int c = 0; c < n_along; c++) {
+            int active = grid->region[l * line_stride + c * point_stride] > 0;
+            count += active && !prev;
+            prev = active;
+        }
+        span_ptr[l + 1] = count;
+    }
+    span_ptr[0] = 0;
+    for (int l = 0; l < n_lines; l++) {
+        span_ptr[l + 1] += span_ptr[l];
+    }
+
+    GridSpan *spans = (GridSpan *)malloc((span_ptr[n_lines] > 0 ? span_ptr[n_lines] : 1) * sizeof(GridSpan));
+    #pragma omp parallel for schedule(static) if (parallel)
+    for (int l = 0; l < n_lines; l++) {
+        int next = span_ptr[l];
+        int c = 0;
+        while (c < n_along) {
+            if (grid->region[l * line_stride + c * point_stride] == 0) {
+                c++;
+                continue;
             }
+            int start = c;
+            while (c < n_along && grid->region[l * line_stride + c * point_stride] > 0) c++;
+            spans[next].start = start;
+            spans[next].length = c - start;
+            spans[next].first = grid->id_map[l * line_stride + start * point_stride];
+            next++;
         }
     }
-    grid->id_i = (int *)malloc(grid->n_active * sizeof(int));
-    grid->id_j = (int *)malloc(grid->n_active * sizeof(int));
-    for (int i = 0; i < grid->nx; i++) {
-        for (int j = 0; j < grid->ny; j++) {
-            if (grid->region[i][j] > 0) {
-                grid->id_i[grid->id_map[i][j]] = i;
-                grid->id_j[grid->id_map[i][j]] = j;
+    return spans;
+}
+
+void build_spans_Grid(Grid2D *grid) {
+    if (grid->span_i) return;
+    grid->span_ptr_i = (int *)malloc((grid->nx + 1) * sizeof(int));
+    grid->span_i = line_spans(grid, grid->nx, grid->ny, grid->ny, 1, grid->span_ptr_i);
+    grid->span_ptr_j = (int *)malloc((grid->ny + 1) * sizeof(int));
+    grid->span_j = line_spans(grid, grid->ny, grid->nx, 1, grid->ny, grid->span_ptr_j);
+}
+
+/* Number the active points of the box [i0, i1) x [j0, j1) into perm, separators last. */
+static int nested_dissection_box(Grid2D *grid, int i0, int i1, int j0, int j1, int *perm, int next) {
+    int ni = i1 - i0, nj = j1 - j0;
+    if (ni <= 0 || nj <= 0) return next;
+
+    if (ni * nj <= NESTED_DISSECTION_LEAF_SIZE || (ni < 3 && nj < 3)) {
+        for (int i = i0; i < i1; i++) {
+            for (int j = j0; j < j1; j++) {
+                if (grid_region(grid, i, j) > 0) perm[next++] = grid_id(grid, i, j);
             }
         }
+        return next;
     }
-    return grid;
+
+    // Cut the longer side with a grid line: it separates the two halves of the 5-point stencil
+    if (ni >= nj) {
+        int mid = i0 + ni / 2;
+        next = nested_dissection_box(grid, i0, mid, j0, j1, perm, next);
+        next = nested_dissection_box(grid, mid + 1, i1, j0, j1, perm, next);
+        for (int j = j0; j < j1; j++) {
+            if (grid_region(grid, mid, j) > 0) perm[next++] = grid_id(grid, mid, j);
+        }
+    } else {
+        int mid = j0 + nj / 2;
+        next = nested_dissection_box(grid, i0, i1, j0, mid, perm, next);
+        next = nested_dissection_box(grid, i0, i1, mid + 1, j1, perm, next);
+        for (int i = i0; i < i1; i++) {
+            if (grid_region(grid, i, mid) > 0) perm[next++] = grid_id(grid, i, mid);
+        }
+    }
+    return next;
+}
+
+void nested_dissection_Grid(Grid2D *grid, int *perm) {
+    nested_dissection_box(grid, 0, grid->nx, 0, grid->ny, perm, 0);
+}
+
+int* strip_partition_Grid(Grid2D *grid, int n_parts, int overlap, int *owner, int *part_ptr) {
+    // Cut across the longer side, i.e. along lines of constant j when ny >= nx
+    int along_j = grid->ny >= grid->nx;
+    int n_lines = along_j ? grid->ny : grid->nx;
+    build_spans_Grid(grid);
+    const int *span_ptr = along_j ? grid->span_ptr_j : grid->span_ptr_i;
+    const GridSpan *spans = along_j ? grid->span_j : grid->span_i;
+
+    // Strip s owns the lines [first[s], first[s+1]), balanced by active point count
+    int *first = (int *)malloc((n_parts + 1) * sizeof(int));
+    int count = 0, part = 0;
+    first[0] = 0;
+    for (int l = 0; l < n_lines; l++) {
+        for (int r = span_ptr[l]; r < span_ptr[l + 1]; r++) {
+            count += spans[r].length;
+        }
+        while (part + 1 < n_parts && count >= (long)(part + 1) * grid->n_active / n_parts) {
+            first[++part] = l + 1;
+        }
+    }
+    while (part + 1 <= n_parts) {
+        first[++part] = n_lines;
+    }
+
+    part_ptr[0] = 0;
+    int total = 0;
+    for (int s = 0; s < n_parts; s++) {
+        int l0 = first[s] - overlap > 0 ? first[s] - overlap : 0;
+        int l1 = first[s + 1] + overlap < n_lines ? first[s + 1] + overlap : n_lines;
+        for (int l = l0; l < l1; l++) {
+            for (int r = span_ptr[l]; r < span_ptr[l + 1]; r++) {
+                total += spans[r].length;
+            }
+        }
+        part_ptr[s + 1] = total;
+    }
+
+    int *part_ind = (int *)malloc((total > 0 ? total : 1) * sizeof(int));
+    for (int s = 0; s < n_parts; s++) {
+        int l0 = first[s] - overlap > 0 ? first[s] - overlap : 0;
+        int l1 = first[s + 1] + overlap < n_lines ? first[s + 1] + overlap : n_lines;
+        int next = part_ptr[s];
+        for (int l = l0; l < l1; l++) {
+            int owned = l >= first[s] && l < first[s + 1];
+            for (int r = span_ptr[l]; r < span_ptr[l + 1]; r++) {
+                for (int c = spans[r].start; c < spans[r].start + spans[r].length; c++) {
+                    int k = along_j ? grid_id(grid, c, l) : spans[r].first + (c - spans[r].start);
+                    part_ind[next++] = k;
+                    if (owned) owner[k] = s;
+                }
+            }
+        }
+    }
+    free(first);
+    return part_ind;
 }
 
 double **create_grid_2D_array(Grid2D *grid) {
     double **data_points = (double **)malloc(grid->nx * sizeof(double *));
+    double *data = (double *)malloc((size_t)grid->nx * grid->ny * sizeof(double));
     for (int i = 0; i < grid->nx; i++) {
-        data_points[i] = (double *)malloc(grid->ny * sizeof(double));
+        data_points[i] = data + (size_t)i * grid->ny;
     }
     return data_points;
 }
 
 void* free_grid_2D_array(double** array, Grid2D *grid) {
-    for (int i = 0; i < grid->nx; i++) {
-        free(array[i]);
+    (void)grid;
+    if (array) {
+        free(array[0]);
+        free(array);
+    }
+    return NULL;
+}
+
+/* Copy the active values of grid line i from data_indices into row, zeroing the exterior points. */
+static void indices_to_line(const Grid2D *grid, int i, const double *data_indices, double *row) {
+    int j = 0;
+    for (int s = grid->span_ptr_i[i]; s < grid->span_ptr_i[i + 1]; s++) {
+        const GridSpan *span = &grid->span_i[s];
+        for (; j < span->start; j++) {
+            row[j] = 0.0; // or some sentinel value for inactive points
+        }
+        memcpy(row + span->start, data_indices + span->first, span->length * sizeof(double));
+        j = span->start + span->length;
+    }
+    for (; j < grid->ny; j++) {
+        row[j] = 0.0;
+    }
+}
+
+/* Copy the active values of grid line i from row into data_indices. */
+static void line_to_indices(const Grid2D *grid, int i, const double *row, double *data_indices) {
+    for (int s = grid->span_ptr_i[i]; s < grid->span_ptr_i[i + 1]; s++) {
+        const GridSpan *span = &grid->span_i[s];
+        memcpy(data_indices + span->first, row + span->start, span->length * sizeof(double));
     }
-    free(array);
 }
 
 void read_indices_to_points(Grid2D *grid, double* data_indices, double **data_points) {
-    // double **data_points = (double **)malloc(grid->nx * sizeof(double *));
+    build_spans_Grid(grid);
+    #pragma omp parallel for schedule(static) if ((size_t)grid->nx * grid->ny >= GRID_PARALLEL_MIN_POINTS)
     for (int i = 0; i < grid->nx; i++) {
-        data_points[i] = (double *)malloc(grid->ny * sizeof(double));
-        for (int j = 0; j < grid->ny; j++) {
-            if (grid->region[i][j] == 0) {
-                data_points[i][j] = 0.0; // or some sentinel value for inactive points
-            } else {
-                data_points[i][j] = data_indices[grid->id_map[i][j]];
-            }
-        }
+        indices_to_line(grid, i, data_indices, data_points[i]);
+    }
+}
+
+void read_points_to_indices(Grid2D *grid, double **data_points, double *data_indices) {
+    build_spans_Grid(grid);
+    #pragma omp parallel for schedule(static) if ((size_t)grid->nx * grid->ny >= GRID_PARALLEL_MIN_POINTS)
+    for (int i = 0; i < grid->nx; i++) {
+        line_to_indices(grid, i, data_points[i], data_indices);
+    }
+}
+
+void read_indices_to_array(Grid2D *grid, const double *data_indices, double *data_array) {
+    build_spans_Grid(grid);
+    #pragma omp parallel for schedule(static) if ((size_t)grid->nx * grid->ny >= GRID_PARALLEL_MIN_POINTS)
+    for (int i = 0; i < grid->nx; i++) {
+        indices_to_line(grid, i, data_indices, data_array + grid_index(grid, i, 0));
+    }
+}
+
+void read_array_to_indices(Grid2D *grid, const double *data_array, double *data_indices) {
+    build_spans_Grid(grid);
+    #pragma omp parallel for schedule(static) if ((size_t)grid->nx * grid->ny >= GRID_PARALLEL_MIN_POINTS)
+    for (int i = 0; i < grid->nx; i++) {
+        line_to_indices(grid, i, data_array + grid_index(grid, i, 0), data_indices);
     }
-    // return data_points;
 }
 
 void* free_grid(Grid2D *grid) {
     if (grid) {
         free(grid->x);
         free(grid->y);
-        if (grid->region) {
-            for (int i = 0; i < grid->nx; i++) {
-                free(grid->region[i]);
-            }
-            free(grid->region);
-        }
-        if (grid->id_map) {
-            for (int i = 0; i < grid->nx; i++) {
-                free(grid->id_map[i]);
-            }
-            free(grid->id_map);
-        }
-        if (grid->id_i) {
-            free(grid->id_i);
-        }
-        if (grid->id_j) {
-            free(grid->id_j);
-        }
+        free(grid->region);
+        free(grid->id_map);
+        free(grid->id_i);
+        free(grid->id_j);
+        free(grid->neighbors);
+        free(grid->span_ptr_i);
+        free(grid->span_i);
+        free(grid->span_ptr_j);
+        free(grid->span_j);
         free(grid);
     }
-}
\ No newline at end of file
+    return NULL;
+}
@@ -9,8 +9,14 @@
  *    time-step update on the active grid points.
  *  - `assemble_RHS_Parabolic`: fill the RHS vector using a provided source-term
  *    callback and Dirichlet boundary value callback.
+ *  - `step_Parabolic`: time-step update A * u + RHS in one pass, the RHS of every
+ *    row added by the (tuned) SpMV kernel of the matrix as the row is written.
  *  - `assemble_Matrix_Parabolic_ADI`: construct directional ADI split operators
  *    (arrays of CSR matrices) for alternating-direction implicit methods.
+ *  - `estimate_stable_tau_Parabolic_Explicit`: estimate the largest stable
+ *    explicit time-step from the spectrum of the assembled operator.
+ *  - `SolutionHistory` helpers: keep the last few solutions of a time loop and
+ *    extrapolate them into the initial guess of the next implicit solve.
  *
  * The functions operate on the `Grid2D` structure and return newly allocated
  * `SparseCSR` objects (or arrays of them) which the caller must free when no
@@ -23,6 +29,18 @@
 #include <math.h>
 #include "parabolic.h"
 
+/* Lanczos steps used when estimating the explicit stability limit. */
+#define PARABOLIC_LANCZOS_STEPS 40
+
+/* Right-hand side of step_Parabolic(), evaluated row by row inside the product. */
+typedef struct {
+    const Grid2D *grid;
+    parabolic_source_term f;
+    parabolic_Dirichlet_boundary compute_boundary_value;
+    double t;
+    double tau;
+} parabolic_rhs;
+
 /**
  * @brief Assemble the sparse matrix for an explicit parabolic time-step.
  *
@@ -42,6 +60,7 @@ SparseCSR* assemble_Matrix_Parabolic_Explicit(Grid2D* grid, double tau) {
 
     int idx = 0;
     row_ptr[0] = 0;
+    build_neighbors_Grid(grid);
 
     double mu_x = tau / grid->hx / grid->hx;
     double mu_y = tau / grid->hy / grid->hy;
@@ -49,11 +68,12 @@ SparseCSR* assemble_Matrix_Parabolic_Explicit(Grid2D* grid, double tau) {
     for (int i = 0; i < grid->n_active; i++) {
         int gi = grid->id_i[i];
         int gj = grid->id_j[i];
+        const int *nb = grid_neighbors(grid, i);
         double xi = grid->x[gi];
         double yj = grid->y[gj];
 
         // Interior point
-        if (grid->region[gi][gj] == 1) {
+        if (grid_region(grid, gi, gj) == 1) {
             // Center
             int row = i;
             int col = i;
@@ -62,25 +82,25 @@ SparseCSR* assemble_Matrix_Parabolic_Explicit(Grid2D* grid, double tau) {
             idx++;
 
             // Left
-            col = grid->id_map[gi - 1][gj];
+            col = nb[GRID_LEFT];
             col_ind[idx] = col;
             values[idx] = mu_x;
             idx++;
 
             // Right
-            col = grid->id_map[gi + 1][gj];
+            col = nb[GRID_RIGHT];
             col_ind[idx] = col;
             values[idx] = mu_x;
             idx++;
 
             // Down
-            col = grid->id_map[gi][gj - 1];
+            col = nb[GRID_DOWN];
             col_ind[idx] = col;
             values[idx] = mu_y;
             idx++;
 
             // Up
-            col = grid->id_map[gi][gj + 1];
+            col = nb[GRID_UP];
             col_ind[idx] = col;
             values[idx] = mu_y;
             idx++;
@@ -101,6 +121,32 @@ SparseCSR* assemble_Matrix_Parabolic_Explicit(Grid2D* grid, double tau) {
     return matrix;
 }
 
+/**
+ * @brief Estimate the largest stable time-step of the explicit scheme.
+ *
+ * The explicit update on the interior points is u <- (I - tau*A) u + ..., where
+ * A = I - M(1) and M(1) is the explicit matrix for tau = 1. The scheme is stable
+ * while tau * lambda_max(A) <= 2. Boundary rows of A reduce to the identity, so
+ * Lanczos_eig_bounds_csr() only sees the symmetric interior block.
+ *
+ * @param grid Pointer to Grid2D describing the mesh and active indices.
+ * @param safety Safety factor in (0, 1] applied to the stability limit.
+ * @return Estimated stable time-step size.
+ */
+double estimate_stable_tau_Parabolic_Explicit(Grid2D* grid, double safety) {
+    SparseCSR *matrix = assemble_Matrix_Parabolic_Explicit(grid, 1.0);
+    for (int i = 0; i < matrix->rows; i++) {
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            matrix->values[j] = (matrix->col_ind[j] == i) ? 1.0 - matrix->values[j] : -matrix->values[j];
+        }
+    }
+
+    double lambda_min, lambda_max;
+    Lanczos_eig_bounds_csr(matrix, PARABOLIC_LANCZOS_STEPS, &lambda_min, &lambda_max);
+    freeSparseCSR(matrix);
+    return safety * 2.0 / lambda_max;
+}
+
 /**
  * @brief Assemble the right-hand side vector for a parabolic step.
  *
@@ -126,18 +172,54 @@ void assemble_RHS_Parabolic(Grid2D* grid, parabolic_source_term f, parabolic_Dir
         double yj = grid->y[gj];
 
         // Interior point
-        if (grid->region[gi][gj] == 1) {
+        if (grid_region(grid, gi, gj) == 1) {
             b[i] = f(xi, yj, (t - tau / 2), hx, hy) * tau; // Intergrated Source term!!
         }
         // Boundary point
         else {
             // Dirichlet conditions based on boundary type
-            b[i] = compute_boundary_value(xi, yj, t, grid->region[gi][gj]);
+            b[i] = compute_boundary_value(xi, yj, t, grid_region(grid, gi, gj));
         }
     }
     // return b;
 }
 
+/* Row i of the right-hand side of assemble_RHS_Parabolic(). */
+static double parabolic_rhs_row(int i, const void *ctx) {
+    const parabolic_rhs *rhs = (const parabolic_rhs *)ctx;
+    const Grid2D *grid = rhs->grid;
+    int gi = grid->id_i[i];
+    int gj = grid->id_j[i];
+    double xi = grid->x[gi];
+    double yj = grid->y[gj];
+    if (grid_region(grid, gi, gj) == 1) {
+        return rhs->f(xi, yj, (rhs->t - rhs->tau / 2), grid->hx, grid->hy) * rhs->tau;
+    }
+    return rhs->compute_boundary_value(xi, yj, rhs->t, grid_region(grid, gi, gj));
+}
+
+/**
+ * @brief Time-step update u_out = A * u + b(t, tau).
+ *
+ * The right-hand side of assemble_RHS_Parabolic() is computed row by row inside the
+ * product of spmv_axpby_term_csr(), so u_out is written once and no RHS vector is
+ * needed. The product uses the plan attached by tune_spmv_csr(), if any; the rows
+ * are threaded on large grids.
+ *
+ * @param grid Pointer to the Grid2D structure.
+ * @param matrix Step operator (explicit iteration matrix or an ADI half-step operator).
+ * @param f Source term callback.
+ * @param compute_boundary_value Dirichlet boundary callback.
+ * @param u Current solution (must not alias u_out).
+ * @param u_out Output vector of length `grid->n_active`.
+ * @param t Time at the end of the step.
+ * @param tau Time-step size.
+ */
+void step_Parabolic(Grid2D* grid, const SparseCSR *matrix, parabolic_source_term f, parabolic_Dirichlet_boundary compute_boundary_value, const double *u, double *u_out, double t, double tau) {
+    parabolic_rhs rhs = {grid, f, compute_boundary_value, t, tau};
+    spmv_axpby_term_csr(matrix, 1.0, u, 0.0, u_out, parabolic_rhs_row, &rhs);
+}
+
 /**
  * @brief Assemble the split ADI matrices used by an ADI parabolic solver.
  *
@@ -162,15 +244,17 @@ SparseCSR** assemble_Matrix_Parabolic_ADI(Grid2D* grid, double tau) {
 
     int idx = 0;
     row_ptr[0] = 0;
+    build_neighbors_Grid(grid);
 
     for (int i = 0; i < grid->n_active; i++) {
         int gi = grid->id_i[i];
         int gj = grid->id_j[i];
+        const int *nb = grid_neighbors(grid, i);
         double xi = grid->x[gi];
         double yj = grid->y[gj];
 
         // Interior point
-        if (grid->region[gi][gj] == 1) {
+        if (grid_region(grid, gi, gj) == 1) {
             // Center
             int row = i;
             int col = i;
@@ -179,13 +263,13 @@ SparseCSR** assemble_Matrix_Parabolic_ADI(Grid2D* grid, double tau) {
             idx++;
 
             // Down
-            col = grid->id_map[gi][gj - 1];
+            col = nb[GRID_DOWN];
             col_ind[idx] = col;
             values[idx] = mu_y / 2;
             idx++;
 
             // Up
-            col = grid->id_map[gi][gj + 1];
+            col = nb[GRID_UP];
             col_ind[idx] = col;
             values[idx] = mu_y / 2;
             idx++;
@@ -214,11 +298,12 @@ SparseCSR** assemble_Matrix_Parabolic_ADI(Grid2D* grid, double tau) {
     for (int i = 0; i < grid->n_active; i++) {
         int gi = grid->id_i[i];
         int gj = grid->id_j[i];
+        const int *nb = grid_neighbors(grid, i);
         double xi = grid->x[gi];
         double yj = grid->y[gj];
 
         // Interior point
-        if (grid->region[gi][gj] == 1) {
+        if (grid_region(grid, gi, gj) == 1) {
             // Center
             int row = i;
             int col = i;
@@ -227,13 +312,13 @@ SparseCSR** assemble_Matrix_Parabolic_ADI(Grid2D* grid, double tau) {
             idx++;
 
             // Left
-            col = grid->id_map[gi - 1][gj];
+            col = nb[GRID_LEFT];
             col_ind[idx] = col;
             values[idx] = - mu_x / 2;
             idx++;
 
             // Right
-            col = grid->id_map[gi + 1][gj];
+            col = nb[GRID_RIGHT];
             col_ind[idx] = col;
             values[idx] = - mu_x / 2;
             idx++;
@@ -262,11 +347,12 @@ SparseCSR** assemble_Matrix_Parabolic_ADI(Grid2D* grid, double tau) {
     for (int i = 0; i < grid->n_active; i++) {
         int gi = grid->id_i[i];
         int gj = grid->id_j[i];
+        const int *nb = grid_neighbors(grid, i);
         double xi = grid->x[gi];
         double yj = grid->y[gj];
 
         // Interior point
-        if (grid->region[gi][gj] == 1) {
+        if (grid_region(grid, gi, gj) == 1) {
             // Center
             int row = i;
             int col = i;
@@ -275,13 +361,13 @@ SparseCSR** assemble_Matrix_Parabolic_ADI(Grid2D* grid, double tau) {
             idx++;
 
             // Left
-            col = grid->id_map[gi - 1][gj];
+            col = nb[GRID_LEFT];
             col_ind[idx] = col;
             values[idx] = mu_x / 2;
             idx++;
 
             // Right
-            col = grid->id_map[gi + 1][gj];
+            col = nb[GRID_RIGHT];
             col_ind[idx] = col;
             values[idx] = mu_x / 2;
             idx++;
@@ -310,11 +396,12 @@ SparseCSR** assemble_Matrix_Parabolic_ADI(Grid2D* grid, double tau) {
     for (int i = 0; i < grid->n_active; i++) {
         int gi = grid->id_i[i];
         int gj = grid->id_j[i];
+        const int *nb = grid_neighbors(grid, i);
         double xi = grid->x[gi];
         double yj = grid->y[gj];
 
         // Interior point
-        if (grid->region[gi][gj] == 1) {
+        if (grid_region(grid, gi, gj) == 1) {
             // Center
             int row = i;
             int col = i;
@@ -323,13 +410,13 @@ SparseCSR** assemble_Matrix_Parabolic_ADI(Grid2D* grid, double tau) {
             idx++;
 
             // Down
-            col = grid->id_map[gi][gj - 1];
+            col = nb[GRID_DOWN];
             col_ind[idx] = col;
             values[idx] = - mu_y / 2;
             idx++;
 
             // Up
-            col = grid->id_map[gi][gj + 1];
+            col = nb[GRID_UP];
             col_ind[idx] = col;
             values[idx] = - mu_y / 2;
             idx++;
@@ -350,6 +437,80 @@ SparseCSR** assemble_Matrix_Parabolic_ADI(Grid2D* grid, double tau) {
     return ADI_matrixs;
 }
 
+/**
+ * @brief Create an empty solution history for extrapolated initial guesses.
+ *
+ * @param n Length of the solution vectors (usually grid->n_active).
+ * @param order Number of past solutions kept; the extrapolation polynomial
+ *              has degree order - 1.
+ * @return Pointer to the newly allocated history.
+ */
+SolutionHistory* create_Solution_History(int n, int order) {
+    SolutionHistory *history = (SolutionHistory *)malloc(sizeof(SolutionHistory));
+    history->n = n;
+    history->order = order;
+    history->count = 0;
+    history->head = -1;
+    history->data = (double *)malloc((size_t)order * n * sizeof(double));
+    return history;
+}
+
+/**
+ * @brief Record the solution of the latest time-step, dropping the oldest one if full.
+ *
+ * @param history Pointer to the history.
+ * @param u Solution vector of length history->n.
+ */
+void push_Solution_History(SolutionHistory *history, const double *u) {
+    history->head = (history->head + 1) % history->order;
+    vec_copy(history->data + (size_t)history->head * history->n, u, history->n);
+    if (history->count < history->order) {
+        history->count++;
+    }
+}
+
+/**
+ * @brief Extrapolate the stored solutions to the next time-step.
+ *
+ * Evaluates the polynomial through the last q = count solutions (equal steps)
+ * at the next step: guess = sum_j (-1)^j C(q, j+1) u_{n-j}, i.e. u_n,
+ * 2u_n - u_{n-1}, 3u_n - 3u_{n-1} + u_{n-2}, ... Leaves `guess` untouched
+ * when the history is empty.
+ *
+ * @param history Pointer to the history.
+ * @param guess Output vector of length history->n.
+ */
+void extrapolate_Solution_History(const SolutionHistory *history, double *guess) {
+    int n = history->n;
+    int q = history->count;
+    if (q == 0) return;
+
+    double coef = 1.0, binom = q;
+    for (int i = 0; i < n; i++) {
+        guess[i] = 0.0;
+    }
+    for (int j = 0; j < q; j++) {
+        // binom = C(q, j + 1)
+        coef = ((j % 2) ? -1.0 : 1.0) * binom;
+        int slot = (history->head - j + history->order) % history->order;
+        const double *u = history->data + (size_t)slot * n;
+        vec_axpy(guess, coef, u, n);
+        binom = binom * (q - j - 1) / (j + 2);
+    }
+}
+
+/**
+ * @brief Free the memory allocated for a solution history.
+ *
+ * @param history Pointer to the history to free.
+ */
+void free_Solution_History(SolutionHistory *history) {
+    if (history) {
+        free(history->data);
+        free(history);
+    }
+}
+
 void* solve_Parabolic_ADI(Grid2D* grid, SparseCSR** ADI_matrix, double t, double tau, double* b, double) {
     SparseCSR *plus_delta_y = ADI_matrix[0], *minus_delta_x = ADI_matrix[1],
               *plus_delta_x = ADI_matrix[2], *minus_delta_y = ADI_matrix[3];
@@ -367,7 +528,7 @@ void* solve_Parabolic_ADI(Grid2D* grid, SparseCSR** ADI_matrix, double t, double
 //         double yj = grid->y[gj];
 
 //         // Interior point
-//         if (grid->region[gi][gj] == 1) {
+//         if (grid_region(grid, gi, gj) == 1) {
 //             if (flag) {
 //                 b[i] = get_exact(xi, yj);
 //                 flag = 0;
@@ -378,7 +539,7 @@ void* solve_Parabolic_ADI(Grid2D* grid, SparseCSR** ADI_matrix, double t, double
 //         // Boundary point
 //         else {
 //             // Neumann conditions based on boundary type
-//             b[i] = compute_boundary_value(xi, yj, grid->region[gi][gj]) * h;
+//             b[i] = compute_boundary_value(xi, yj, grid_region(grid, gi, gj)) * h;
 //         }
 //     }
 //     return b;
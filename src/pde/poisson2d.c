@@ -23,15 +23,17 @@ SparseCSR* assemble_Matrix_Dirichlet(Grid2D* grid) {
 
     int idx = 0;
     row_ptr[0] = 0;
+    build_neighbors_Grid(grid);
 
     for (int i = 0; i < grid->n_active; i++) {
         int gi = grid->id_i[i];
         int gj = grid->id_j[i];
+        const int *nb = grid_neighbors(grid, i);
         double xi = grid->x[gi];
         double yj = grid->y[gj];
 
         // Interior point
-        if (grid->region[gi][gj] == 1) {
+        if (grid_region(grid, gi, gj) == 1) {
             // Center
             int row = i;
             int col = i;
@@ -40,25 +42,25 @@ SparseCSR* assemble_Matrix_Dirichlet(Grid2D* grid) {
             idx++;
 
             // Left
-            col = grid->id_map[gi - 1][gj];
+            col = nb[GRID_LEFT];
             col_ind[idx] = col;
             values[idx] = -1.0;
             idx++;
 
             // Right
-            col = grid->id_map[gi + 1][gj];
+            col = nb[GRID_RIGHT];
             col_ind[idx] = col;
             values[idx] = -1.0;
             idx++;
 
             // Down
-            col = grid->id_map[gi][gj - 1];
+            col = nb[GRID_DOWN];
             col_ind[idx] = col;
             values[idx] = -1.0;
             idx++;
 
             // Up
-            col = grid->id_map[gi][gj + 1];
+            col = nb[GRID_UP];
             col_ind[idx] = col;
             values[idx] = -1.0;
             idx++;
@@ -89,13 +91,13 @@ double* assemble_RHS_Dirichlet(Grid2D* grid, f_func f, boundary_func compute_bou
         double yj = grid->y[gj];
 
         // Interior point
-        if (grid->region[gi][gj] == 1) {
+        if (grid_region(grid, gi, gj) == 1) {
             b[i] = f(xi, yj) * h * h; // Source term
         }
         // Boundary point
         else {
             // Dirichlet conditions based on boundary type
-            b[i] = compute_boundary_value(xi, yj, grid->region[gi][gj]);
+            b[i] = compute_boundary_value(xi, yj, grid_region(grid, gi, gj));
         }
     }
     return b;
@@ -109,15 +111,17 @@ SparseCSR* assemble_Matrix_Neumann(Grid2D* grid, normal_func get_normal) {
 
     int idx = 0, flag = 1;
     row_ptr[0] = 0;
+    build_neighbors_Grid(grid);
 
     for (int i = 0; i < grid->n_active; i++) {
         int gi = grid->id_i[i];
         int gj = grid->id_j[i];
+        const int *nb = grid_neighbors(grid, i);
         double xi = grid->x[gi];
         double yj = grid->y[gj];
 
         // Interior point
-        if (grid->region[gi][gj] == 1) {
+        if (grid_region(grid, gi, gj) == 1) {
             if (flag) {
                 col_ind[idx] = i;
                 values[idx] = 1.0;
@@ -132,25 +136,25 @@ SparseCSR* assemble_Matrix_Neumann(Grid2D* grid, normal_func get_normal) {
                 idx++;
 
                 // Left
-                col = grid->id_map[gi - 1][gj];
+                col = nb[GRID_LEFT];
                 col_ind[idx] = col;
                 values[idx] = -1.0;
                 idx++;
 
                 // Right
-                col = grid->id_map[gi + 1][gj];
+                col = nb[GRID_RIGHT];
                 col_ind[idx] = col;
                 values[idx] = -1.0;
                 idx++;
 
                 // Down
-                col = grid->id_map[gi][gj - 1];
+                col = nb[GRID_DOWN];
                 col_ind[idx] = col;
                 values[idx] = -1.0;
                 idx++;
 
                 // Up
-                col = grid->id_map[gi][gj + 1];
+                col = nb[GRID_UP];
                 col_ind[idx] = col;
                 values[idx] = -1.0;
                 idx++;
@@ -159,7 +163,7 @@ SparseCSR* assemble_Matrix_Neumann(Grid2D* grid, normal_func get_normal) {
 
         // Boundary point
         else {
-            double alpha = get_normal(grid->region[gi][gj]);
+            double alpha = get_normal(grid_region(grid, gi, gj));
             int row = i;
             int col = i;
             col_ind[idx] = col;
@@ -168,12 +172,12 @@ SparseCSR* assemble_Matrix_Neumann(Grid2D* grid, normal_func get_normal) {
 
             if (fabs(sin(alpha)) > 1e-12) {
                 if (sin(alpha) > 0) { // Bottom boundary
-                    col = grid->id_map[gi][gj - 1];
+                    col = nb[GRID_DOWN];
                     col_ind[idx] = col;
                     values[idx] = -sin(alpha);
                     idx++;
                 } else { // Top boundary
-                    col = grid->id_map[gi][gj + 1];
+                    col = nb[GRID_UP];
                     col_ind[idx] = col;
                     values[idx] = sin(alpha);
                     idx++;
@@ -181,12 +185,12 @@ SparseCSR* assemble_Matrix_Neumann(Grid2D* grid, normal_func get_normal) {
             }
             if (fabs(cos(alpha)) > 1e-12) {
                 if (cos(alpha) > 0) { // Left boundary
-                    col = grid->id_map[gi - 1][gj];
+                    col = nb[GRID_LEFT];
                     col_ind[idx] = col;
                     values[idx] = -cos(alpha);
                     idx++;
                 } else { // Right boundary
-                    col = grid->id_map[gi + 1][gj];
+                    col = nb[GRID_RIGHT];
                     col_ind[idx] = col;
                     values[idx] = cos(alpha);
                     idx++;
@@ -210,7 +214,7 @@ double* assemble_RHS_Neumann(Grid2D* grid, f_func f, boundary_func compute_bound
         double yj = grid->y[gj];
 
         // Interior point
-        if (grid->region[gi][gj] == 1) {
+        if (grid_region(grid, gi, gj) == 1) {
             if (flag) {
                 b[i] = get_exact(xi, yj);
                 flag = 0;
@@ -221,7 +225,7 @@ double* assemble_RHS_Neumann(Grid2D* grid, f_func f, boundary_func compute_bound
         // Boundary point
         else {
             // Neumann conditions based on boundary type
-            b[i] = compute_boundary_value(xi, yj, grid->region[gi][gj]) * h;
+            b[i] = compute_boundary_value(xi, yj, grid_region(grid, gi, gj)) * h;
         }
     }
     return b;
@@ -2,10 +2,14 @@
  * @file csr.c
  * @brief Implementation of sparse matrix operations in CSR format.
  * 
- * This file includes functions for creating, freeing, decomposing, matrix-vector
- * multiplication, and solving linear systems using iterative methods (Jacobi,
- * Gauss-Seidel, Conjugate Gradient) for sparse matrices stored in Compressed
- * Sparse Row (CSR) format.
+ * This file includes functions for creating, freeing, decomposing (by copy or
+ * through zero-copy D/L/U views), matrix-vector multiplication, and solving
+ * linear systems using iterative methods (Jacobi, Gauss-Seidel, SOR/SSOR with
+ * estimated relaxation parameters, (preconditioned) Conjugate Gradient, s-step and deflated Conjugate Gradient, Chebyshev) for
+ * sparse matrices stored in Compressed Sparse Row (CSR) format, together with
+ * power-iteration and Lanczos estimates of the extreme eigenvalues, a fused
+ * y = alpha*A*x + beta*y + b kernel, a cache-blocked matrix-powers kernel, and (OpenMP-parallel) transposition and
+ * sparse matrix-matrix products.
  * 
  * @author Li Zhijun
  * @date 2025-10-10
@@ -14,6 +18,55 @@
 #include <stdio.h>
 #include <math.h>
 #include "csr.h"
+#include "spmv.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Chebyshev_csr only evaluates the residual norm every this many iterations. */
+#define CHEBYSHEV_CHECK_INTERVAL 10
+
+/* Rows per block of the matrix-powers wavefront. */
+#define MATRIX_POWERS_BLOCK_ROWS 2048
+
+/* Lanczos steps used to place the shifts of the s-step Krylov basis. */
+#define SSTEP_LANCZOS_STEPS 20
+
+/*
+ * Lanczos steps of the first estimate of the Jacobi spectral radius; the count is
+ * doubled (up to the maximum) until 1 - rho changes by less than the tolerance.
+ */
+#define SOR_LANCZOS_STEPS 20
+#define SOR_LANCZOS_MAX_STEPS 1280
+#define SOR_LANCZOS_TOL 0.05
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static int csr_max_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+static int csr_num_threads(void) {
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+static int csr_thread_id(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
 
 SparseCSR* createSparseCSR(int rows, int cols, int nnz) {
     SparseCSR *matrix = (SparseCSR *)malloc(sizeof(SparseCSR));
@@ -23,6 +76,7 @@ SparseCSR* createSparseCSR(int rows, int cols, int nnz) {
     matrix->row_ptr = (int *)malloc((rows + 1) * sizeof(int));
     matrix->col_ind = (int *)malloc(nnz * sizeof(int));
     matrix->values = (double *)malloc(nnz * sizeof(double));
+    matrix->plan = NULL;
     return matrix;
 }
 
@@ -31,11 +85,16 @@ void freeSparseCSR(SparseCSR *matrix) {
         free(matrix->row_ptr);
         free(matrix->col_ind);
         free(matrix->values);
+        freeSpMVPlan(matrix->plan);
         free(matrix);
     }
 }
 
 void spmv_csr(const SparseCSR *matrix, const double *x, double *y) {
+    if (matrix->plan) {
+        apply_SpMVPlan(matrix->plan, x, y);
+        return;
+    }
     for (int i = 0; i < matrix->rows; i++) {
         y[i] = 0.0;
         for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
@@ -44,6 +103,37 @@ void spmv_csr(const SparseCSR *matrix, const double *x, double *y) {
     }
 }
 
+/* y = alpha * A * x + beta * y + b + term, rows summed in CSR order; the plan kernels do the same. */
+static void csr_axpby(const SparseCSR *matrix, double alpha, const double *x, double beta, double *y, const double *b, csr_row_term term, const void *ctx) {
+    if (matrix->plan) {
+        apply_axpby_SpMVPlan(matrix->plan, alpha, x, beta, y, b, term, ctx);
+        return;
+    }
+    const int *row_ptr = matrix->row_ptr;
+    const int *col_ind = matrix->col_ind;
+    const double *values = matrix->values;
+    #pragma omp parallel for schedule(static) if (matrix->nnz >= CSR_PARALLEL_MIN_NNZ || (term && matrix->rows >= CSR_TERM_PARALLEL_MIN_ROWS))
+    for (int i = 0; i < matrix->rows; i++) {
+        double sum = 0.0;
+        for (int j = row_ptr[i]; j < row_ptr[i + 1]; j++) {
+            sum += values[j] * x[col_ind[j]];
+        }
+        double result = alpha * sum;
+        if (beta != 0.0) result += beta * y[i];
+        if (b) result += b[i];
+        if (term) result += term(i, ctx);
+        y[i] = result;
+    }
+}
+
+void spmv_axpby_csr(const SparseCSR *matrix, double alpha, const double *x, double beta, double *y, const double *b) {
+    csr_axpby(matrix, alpha, x, beta, y, b, NULL, NULL);
+}
+
+void spmv_axpby_term_csr(const SparseCSR *matrix, double alpha, const double *x, double beta, double *y, csr_row_term term, const void *ctx) {
+    csr_axpby(matrix, alpha, x, beta, y, NULL, term, ctx);
+}
+
 SparseCSR** get_D_L_U_csr(const SparseCSR *matrix) {
     int rows = matrix->rows;
     int cols = matrix->cols;
@@ -100,102 +190,210 @@ SparseCSR** get_D_L_U_csr(const SparseCSR *matrix) {
     return result;
 }
 
-void Jacobi_csr_debug(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol) {
-    double *x_new = (double *)malloc(matrix->rows * sizeof(double));
-    for (int iter = 0; iter < max_iter; iter++) {
-        for (int i = 0; i < matrix->rows; i++) {
-            double sum = 0.0;
-            double diag = 0.0;
-            for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-                if (matrix->col_ind[j] == i) {
-                    diag = matrix->values[j];
-                } else {
-                    sum += matrix->values[j] * x[matrix->col_ind[j]];
-                }
+void sort_columns_csr(SparseCSR *matrix) {
+    untune_spmv_csr(matrix);
+    for (int i = 0; i < matrix->rows; i++) {
+        // Insertion sort: rows of stencil matrices only hold a handful of entries
+        for (int j = matrix->row_ptr[i] + 1; j < matrix->row_ptr[i + 1]; j++) {
+            int col = matrix->col_ind[j];
+            double val = matrix->values[j];
+            int k = j - 1;
+            while (k >= matrix->row_ptr[i] && matrix->col_ind[k] > col) {
+                matrix->col_ind[k + 1] = matrix->col_ind[k];
+                matrix->values[k + 1] = matrix->values[k];
+                k--;
             }
-            x_new[i] = (b[i] - sum) / diag;
+            matrix->col_ind[k + 1] = col;
+            matrix->values[k + 1] = val;
         }
-        double norm = 0.0;
-        for (int i = 0; i < matrix->rows; i++) {
-            norm += (x_new[i] - x[i]) * (x_new[i] - x[i]);
-            x[i] = x_new[i];
+    }
+}
+
+SplitCSR* createSplitCSR(SparseCSR *matrix) {
+    sort_columns_csr(matrix);
+    SplitCSR *split = (SplitCSR *)malloc(sizeof(SplitCSR));
+    split->matrix = matrix;
+    split->diag_ind = (int *)malloc(matrix->rows * sizeof(int));
+    split->upper_ptr = (int *)malloc(matrix->rows * sizeof(int));
+    for (int i = 0; i < matrix->rows; i++) {
+        int j = matrix->row_ptr[i];
+        while (j < matrix->row_ptr[i + 1] && matrix->col_ind[j] < i) j++;
+        if (j < matrix->row_ptr[i + 1] && matrix->col_ind[j] == i) {
+            split->diag_ind[i] = j;
+            j++;
+        } else {
+            split->diag_ind[i] = -1;
         }
-        norm = sqrt(norm);
-        printf("Jacobi Iteration %d: Residual = %e\n", iter + 1, norm);
-        if (norm < tol) break;
+        split->upper_ptr[i] = j;
     }
-    free(x_new);
+    return split;
 }
 
-void Jacobi_csr(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol) {
-    double *x_new = (double *)malloc(matrix->rows * sizeof(double));
+void freeSplitCSR(SplitCSR *split) {
+    if (split) {
+        free(split->diag_ind);
+        free(split->upper_ptr);
+        free(split);
+    }
+}
+
+void get_diag_split_csr(const SplitCSR *split, double *d) {
+    const SparseCSR *matrix = split->matrix;
+    for (int i = 0; i < matrix->rows; i++) {
+        d[i] = (split->diag_ind[i] >= 0) ? matrix->values[split->diag_ind[i]] : 0.0;
+    }
+}
+
+void spmv_lower_split_csr(const SplitCSR *split, const double *x, double *y) {
+    const SparseCSR *matrix = split->matrix;
+    for (int i = 0; i < matrix->rows; i++) {
+        int end = (split->diag_ind[i] >= 0) ? split->diag_ind[i] : split->upper_ptr[i];
+        double sum = 0.0;
+        for (int j = matrix->row_ptr[i]; j < end; j++) {
+            sum += matrix->values[j] * x[matrix->col_ind[j]];
+        }
+        y[i] = sum;
+    }
+}
+
+void spmv_upper_split_csr(const SplitCSR *split, const double *x, double *y) {
+    const SparseCSR *matrix = split->matrix;
+    for (int i = 0; i < matrix->rows; i++) {
+        double sum = 0.0;
+        for (int j = split->upper_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            sum += matrix->values[j] * x[matrix->col_ind[j]];
+        }
+        y[i] = sum;
+    }
+}
+
+void spmv_offdiag_split_csr(const SplitCSR *split, const double *x, double *y) {
+    const SparseCSR *matrix = split->matrix;
+    for (int i = 0; i < matrix->rows; i++) {
+        int end = (split->diag_ind[i] >= 0) ? split->diag_ind[i] : split->upper_ptr[i];
+        double sum = 0.0;
+        for (int j = matrix->row_ptr[i]; j < end; j++) {
+            sum += matrix->values[j] * x[matrix->col_ind[j]];
+        }
+        for (int j = split->upper_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            sum += matrix->values[j] * x[matrix->col_ind[j]];
+        }
+        y[i] = sum;
+    }
+}
+
+void lower_solve_split_csr(const SplitCSR *split, const double *b, double *x) {
+    const SparseCSR *matrix = split->matrix;
+    for (int i = 0; i < matrix->rows; i++) {
+        double sum = b[i];
+        for (int j = matrix->row_ptr[i]; j < split->diag_ind[i]; j++) {
+            sum -= matrix->values[j] * x[matrix->col_ind[j]];
+        }
+        x[i] = sum / matrix->values[split->diag_ind[i]];
+    }
+}
+
+void upper_solve_split_csr(const SplitCSR *split, const double *b, double *x) {
+    const SparseCSR *matrix = split->matrix;
+    for (int i = matrix->rows - 1; i >= 0; i--) {
+        double sum = b[i];
+        for (int j = split->upper_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            sum -= matrix->values[j] * x[matrix->col_ind[j]];
+        }
+        x[i] = sum / matrix->values[split->diag_ind[i]];
+    }
+}
+
+/*
+ * Position of the diagonal entry of every row and its inverse, computed once per solve
+ * so that the sweeps run two branch-free loops around the diagonal and multiply instead
+ * of dividing. The entries before and after the diagonal keep their CSR order, so the
+ * rows need not be sorted. A row without diagonal gets diag_ind = row end and an
+ * infinite inverse (as dividing by the missing diagonal would).
+ */
+static void csr_diagonal_cache(const SparseCSR *matrix, int *diag_ind, double *inv_diag) {
+    for (int i = 0; i < matrix->rows; i++) {
+        int end = matrix->row_ptr[i + 1];
+        diag_ind[i] = end;
+        for (int j = matrix->row_ptr[i]; j < end; j++) {
+            if (matrix->col_ind[j] == i) diag_ind[i] = j;
+        }
+        inv_diag[i] = 1.0 / (diag_ind[i] < end ? matrix->values[diag_ind[i]] : 0.0);
+    }
+}
+
+/* Off-diagonal part of row i times x, in CSR order. */
+static inline double csr_offdiag_row(const SparseCSR *matrix, const int *diag_ind, int i, const double *x) {
+    const int *col_ind = matrix->col_ind;
+    const double *values = matrix->values;
+    double sum = 0.0;
+    for (int j = matrix->row_ptr[i]; j < diag_ind[i]; j++) {
+        sum += values[j] * x[col_ind[j]];
+    }
+    for (int j = diag_ind[i] + 1; j < matrix->row_ptr[i + 1]; j++) {
+        sum += values[j] * x[col_ind[j]];
+    }
+    return sum;
+}
+
+static void Jacobi(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol, int verbose) {
+    int n = matrix->rows;
+    double *x_new = (double *)malloc(n * sizeof(double));
+    int *diag_ind = (int *)malloc(n * sizeof(int));
+    double *inv_diag = (double *)malloc(n * sizeof(double));
+    csr_diagonal_cache(matrix, diag_ind, inv_diag);
     for (int iter = 0; iter < max_iter; iter++) {
-        for (int i = 0; i < matrix->rows; i++) {
-            double sum = 0.0;
-            double diag = 0.0;
-            for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-                if (matrix->col_ind[j] == i) {
-                    diag = matrix->values[j];
-                } else {
-                    sum += matrix->values[j] * x[matrix->col_ind[j]];
-                }
-            }
-            x_new[i] = (b[i] - sum) / diag;
+        for (int i = 0; i < n; i++) {
+            x_new[i] = (b[i] - csr_offdiag_row(matrix, diag_ind, i, x)) * inv_diag[i];
         }
         double norm = 0.0;
-        for (int i = 0; i < matrix->rows; i++) {
+        for (int i = 0; i < n; i++) {
             norm += (x_new[i] - x[i]) * (x_new[i] - x[i]);
             x[i] = x_new[i];
         }
         norm = sqrt(norm);
+        if (verbose) printf("Jacobi Iteration %d: Residual = %e\n", iter + 1, norm);
         if (norm < tol) break;
     }
     free(x_new);
+    free(diag_ind);
+    free(inv_diag);
 }
 
-void GaussSeidel_csr_debug(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol) {
+void Jacobi_csr_debug(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol) {
+    Jacobi(matrix, b, x, max_iter, tol, 1);
+}
+
+void Jacobi_csr(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol) {
+    Jacobi(matrix, b, x, max_iter, tol, 0);
+}
+
+static void GaussSeidel(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol, int verbose) {
+    int n = matrix->rows;
+    int *diag_ind = (int *)malloc(n * sizeof(int));
+    double *inv_diag = (double *)malloc(n * sizeof(double));
+    csr_diagonal_cache(matrix, diag_ind, inv_diag);
     for (int iter = 0; iter < max_iter; iter++) {
         double norm = 0.0;
-        for (int i = 0; i < matrix->rows; i++) {
-            double sum = 0.0;
-            double diag = 0.0;
-            for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-                if (matrix->col_ind[j] == i) {
-                    diag = matrix->values[j];
-                } else {
-                    sum += matrix->values[j] * x[matrix->col_ind[j]];
-                }
-            }
+        for (int i = 0; i < n; i++) {
             double x_old = x[i];
-            x[i] = (b[i] - sum) / diag;
+            x[i] = (b[i] - csr_offdiag_row(matrix, diag_ind, i, x)) * inv_diag[i];
             norm += (x[i] - x_old) * (x[i] - x_old);
         }
         norm = sqrt(norm);
-        printf("GS Iteration %d: Residual = %e\n", iter + 1, norm);
+        if (verbose) printf("GS Iteration %d: Residual = %e\n", iter + 1, norm);
         if (norm < tol) break;
     }
+    free(diag_ind);
+    free(inv_diag);
+}
+
+void GaussSeidel_csr_debug(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol) {
+    GaussSeidel(matrix, b, x, max_iter, tol, 1);
 }
 
 void GaussSeidel_csr(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol) {
-    for (int iter = 0; iter < max_iter; iter++) {
-        double norm = 0.0;
-        for (int i = 0; i < matrix->rows; i++) {
-            double sum = 0.0;
-            double diag = 0.0;
-            for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-                if (matrix->col_ind[j] == i) {
-                    diag = matrix->values[j];
-                } else {
-                    sum += matrix->values[j] * x[matrix->col_ind[j]];
-                }
-            }
-            double x_old = x[i];
-            x[i] = (b[i] - sum) / diag;
-            norm += (x[i] - x_old) * (x[i] - x_old);
-        }
-        norm = sqrt(norm);
-        if (norm < tol) break;
-    }
+    GaussSeidel(matrix, b, x, max_iter, tol, 0);
 }
 
 void CG_csr_debug(const SparseCSR *matrix, const double *b, double *x, int max_iter, double tol) {
@@ -218,10 +416,8 @@ void CG_csr_debug(const SparseCSR *matrix, const double *b, double *x, int max_i
         double pAp = vec_dot(p, Ap, matrix->rows);
         alpha /= pAp;
 
-        for (int i = 0; i < matrix->rows; i++) {
-            x[i] += alpha * p[i];
-            r[i] -= alpha * Ap[i];
-        }
+        vec_axpy(x, alpha, p, matrix->rows);
+        vec_axpy(r, -alpha, Ap, matrix->rows);
 
         double rsnew = vec_dot(r, r, matrix->rows);
 
@@ -229,9 +425,7 @@ void CG_csr_debug(const SparseCSR *matrix, const double *b, double *x, int max_i
 
         if (sqrt(rsnew) < tol) break;
 
-        for (int i = 0; i < matrix->rows; i++) {
-            p[i] = r[i] + (rsnew / rsold) * p[i];
-        }
+        vec_waxpby(p, 1.0, r, rsnew / rsold, p, matrix->rows);
         rsold = rsnew;
     }
 
@@ -260,22 +454,1087 @@ void CG_csr(const SparseCSR *matrix, const double *b, double *x, int max_iter, d
         double pAp = vec_dot(p, Ap, matrix->rows);
         alpha /= pAp;
 
-        for (int i = 0; i < matrix->rows; i++) {
-            x[i] += alpha * p[i];
-            r[i] -= alpha * Ap[i];
-        }
+        vec_axpy(x, alpha, p, matrix->rows);
+        vec_axpy(r, -alpha, Ap, matrix->rows);
 
         double rsnew = vec_dot(r, r, matrix->rows);
 
         if (sqrt(rsnew) < tol) break;
 
-        for (int i = 0; i < matrix->rows; i++) {
-            p[i] = r[i] + (rsnew / rsold) * p[i];
-        }
+        vec_waxpby(p, 1.0, r, rsnew / rsold, p, matrix->rows);
         rsold = rsnew;
     }
 
     free(r);
     free(p);
     free(Ap);
-}
\ No newline at end of file
+}
+
+/* Operator callback used by the eigenvalue estimators below. */
+typedef void (*linear_op_func)(const void *ctx, const double *x, double *y);
+
+static void csr_apply_op(const void *ctx, const double *x, double *y) {
+    spmv_csr((const SparseCSR *)ctx, x, y);
+}
+
+/*
+ * A row holding only its diagonal entry (e.g. a Dirichlet boundary row) decouples
+ * from the rest of the system: vectors that vanish on such rows span an invariant
+ * subspace, on which the assembled operators are symmetric.
+ */
+static int csr_is_decoupled_row(const SparseCSR *matrix, int i) {
+    return matrix->row_ptr[i + 1] - matrix->row_ptr[i] == 1 && matrix->col_ind[matrix->row_ptr[i]] == i;
+}
+
+/* Solve the decoupled rows exactly, so the residual vanishes on them. */
+static void csr_solve_decoupled_rows(const SparseCSR *matrix, const double *b, double *x) {
+    for (int i = 0; i < matrix->rows; i++) {
+        if (csr_is_decoupled_row(matrix, i)) {
+            x[i] = b[i] / matrix->values[matrix->row_ptr[i]];
+        }
+    }
+}
+
+/* Deterministic pseudo-random start vector (normalized), so repeated runs agree. */
+static void eig_start_vector(const SparseCSR *matrix, double *v, int n) {
+    unsigned int seed = 12345u;
+    double norm = 0.0;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        v[i] = 0.5 + (double)((seed >> 16) & 0x7fff) / 32768.0;
+        if (matrix && csr_is_decoupled_row(matrix, i)) v[i] = 0.0;
+        norm += v[i] * v[i];
+    }
+    if (norm == 0.0) {
+        for (int i = 0; i < n; i++) {
+            v[i] = 1.0;
+        }
+        norm = n;
+    }
+    norm = sqrt(norm);
+    for (int i = 0; i < n; i++) {
+        v[i] /= norm;
+    }
+}
+
+static double power_iteration_op(linear_op_func apply, const void *ctx, int n, int max_iter, double tol) {
+    double *v = (double *)malloc(n * sizeof(double));
+    double *w = (double *)malloc(n * sizeof(double));
+    eig_start_vector(NULL, v, n);
+
+    double lambda = 0.0;
+    for (int iter = 0; iter < max_iter; iter++) {
+        apply(ctx, v, w);
+        double norm = vec_norm2(w, n);
+        if (norm == 0.0) {
+            lambda = 0.0;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            v[i] = w[i] / norm;
+        }
+        double diff = fabs(norm - lambda);
+        lambda = norm;
+        if (diff < tol * lambda) break;
+    }
+
+    free(v);
+    free(w);
+    return lambda;
+}
+
+/* Number of eigenvalues of the symmetric tridiagonal matrix (alpha, beta) below x (Sturm count). */
+static int tridiag_count_below(const double *alpha, const double *beta, int m, double x) {
+    int count = 0;
+    double d = 1.0;
+    for (int k = 0; k < m; k++) {
+        double b2 = (k > 0) ? beta[k - 1] * beta[k - 1] : 0.0;
+        d = alpha[k] - x - b2 / d;
+        if (d == 0.0) d = -1e-300;
+        if (d < 0.0) count++;
+    }
+    return count;
+}
+
+/* k-th smallest eigenvalue (0-based) of a symmetric tridiagonal matrix by bisection. */
+static double tridiag_eigenvalue(const double *alpha, const double *beta, int m, int k) {
+    double lo = alpha[0], hi = alpha[0];
+    for (int i = 0; i < m; i++) {
+        double r = 0.0;
+        if (i > 0) r += fabs(beta[i - 1]);
+        if (i < m - 1) r += fabs(beta[i]);
+        if (alpha[i] - r < lo) lo = alpha[i] - r;
+        if (alpha[i] + r > hi) hi = alpha[i] + r;
+    }
+    for (int iter = 0; iter < 200 && hi - lo > 1e-14 * (fabs(lo) + fabs(hi)); iter++) {
+        double mid = 0.5 * (lo + hi);
+        if (tridiag_count_below(alpha, beta, m, mid) > k) hi = mid;
+        else lo = mid;
+    }
+    return 0.5 * (lo + hi);
+}
+
+double power_iteration_csr(const SparseCSR *matrix, int max_iter, double tol) {
+    return power_iteration_op(csr_apply_op, matrix, matrix->rows, max_iter, tol);
+}
+
+/* Lanczos extreme Ritz values of the symmetric operator apply; matrix only selects the decoupled rows. */
+static void lanczos_op(linear_op_func apply, const void *ctx, const SparseCSR *matrix, int n_iter, double *lambda_min, double *lambda_max) {
+    int n = matrix->rows;
+    if (n_iter > n) n_iter = n;
+    double *v_prev = (double *)calloc(n, sizeof(double));
+    double *v = (double *)malloc(n * sizeof(double));
+    double *w = (double *)malloc(n * sizeof(double));
+    double *alpha = (double *)malloc(n_iter * sizeof(double));
+    double *beta = (double *)malloc(n_iter * sizeof(double));
+    eig_start_vector(matrix, v, n);
+
+    int m = 0;
+    double beta_prev = 0.0;
+    for (int k = 0; k < n_iter; k++) {
+        apply(ctx, v, w);
+        vec_axpy(w, -beta_prev, v_prev, n);
+        alpha[k] = vec_dot(w, v, n);
+        vec_axpy(w, -alpha[k], v, n);
+        m = k + 1;
+        beta[k] = vec_norm2(w, n);
+        if (beta[k] < 1e-12 * fabs(alpha[k]) || beta[k] == 0.0) break;
+        for (int i = 0; i < n; i++) {
+            v_prev[i] = v[i];
+            v[i] = w[i] / beta[k];
+        }
+        beta_prev = beta[k];
+    }
+
+    *lambda_min = tridiag_eigenvalue(alpha, beta, m, 0);
+    *lambda_max = tridiag_eigenvalue(alpha, beta, m, m - 1);
+
+    free(v_prev);
+    free(v);
+    free(w);
+    free(alpha);
+    free(beta);
+}
+
+void Lanczos_eig_bounds_csr(const SparseCSR *matrix, int n_iter, double *lambda_min, double *lambda_max) {
+    lanczos_op(csr_apply_op, matrix, matrix, n_iter, lambda_min, lambda_max);
+}
+
+void Chebyshev_csr_debug(const SparseCSR *matrix, const double *b, double *x, double lambda_min, double lambda_max, int max_iter, double tol) {
+    int n = matrix->rows;
+    double *r = (double *)malloc(n * sizeof(double));
+    double *d = (double *)malloc(n * sizeof(double));
+    double *Ad = (double *)malloc(n * sizeof(double));
+
+    double theta = 0.5 * (lambda_max + lambda_min);
+    double delta = 0.5 * (lambda_max - lambda_min);
+    double sigma = theta / delta;
+    double rho = 1.0 / sigma;
+
+    // r = b - A*x, d = r / theta
+    csr_solve_decoupled_rows(matrix, b, x);
+    spmv_csr(matrix, x, r);
+    for (int i = 0; i < n; i++) {
+        r[i] = b[i] - r[i];
+        d[i] = r[i] / theta;
+    }
+
+    for (int iter = 0; iter < max_iter; iter++) {
+        spmv_csr(matrix, d, Ad);
+        vec_add(x, d, n);
+        vec_sub(r, Ad, n);
+
+        double norm = vec_norm2(r, n);
+        printf("Chebyshev Iteration %d: Residual = %e\n", iter + 1, norm);
+        if (norm < tol) break;
+
+        double rho_new = 1.0 / (2.0 * sigma - rho);
+        vec_waxpby(d, rho_new * rho, d, 2.0 * rho_new / delta, r, n);
+        rho = rho_new;
+    }
+
+    free(r);
+    free(d);
+    free(Ad);
+}
+
+void Chebyshev_csr(const SparseCSR *matrix, const double *b, double *x, double lambda_min, double lambda_max, int max_iter, double tol) {
+    int n = matrix->rows;
+    double *r = (double *)malloc(n * sizeof(double));
+    double *d = (double *)malloc(n * sizeof(double));
+    double *Ad = (double *)malloc(n * sizeof(double));
+
+    double theta = 0.5 * (lambda_max + lambda_min);
+    double delta = 0.5 * (lambda_max - lambda_min);
+    double sigma = theta / delta;
+    double rho = 1.0 / sigma;
+
+    // r = b - A*x, d = r / theta
+    csr_solve_decoupled_rows(matrix, b, x);
+    spmv_csr(matrix, x, r);
+    for (int i = 0; i < n; i++) {
+        r[i] = b[i] - r[i];
+        d[i] = r[i] / theta;
+    }
+
+    for (int iter = 0; iter < max_iter; iter++) {
+        spmv_csr(matrix, d, Ad);
+        vec_add(x, d, n);
+        vec_sub(r, Ad, n);
+
+        // The residual norm is the only reduction, so only check it now and then
+        if ((iter + 1) % CHEBYSHEV_CHECK_INTERVAL == 0 && vec_norm2(r, n) < tol) break;
+
+        double rho_new = 1.0 / (2.0 * sigma - rho);
+        vec_waxpby(d, rho_new * rho, d, 2.0 * rho_new / delta, r, n);
+        rho = rho_new;
+    }
+
+    free(r);
+    free(d);
+    free(Ad);
+}
+
+void Chebyshev_smooth_csr(const SparseCSR *matrix, const double *b, double *x, double lambda_min, double lambda_max, int n_steps) {
+    int n = matrix->rows;
+    double *r = (double *)malloc(n * sizeof(double));
+    double *d = (double *)malloc(n * sizeof(double));
+    double *Ad = (double *)malloc(n * sizeof(double));
+
+    double theta = 0.5 * (lambda_max + lambda_min);
+    double delta = 0.5 * (lambda_max - lambda_min);
+    double sigma = theta / delta;
+    double rho = 1.0 / sigma;
+
+    csr_solve_decoupled_rows(matrix, b, x);
+    spmv_csr(matrix, x, r);
+    for (int i = 0; i < n; i++) {
+        r[i] = b[i] - r[i];
+        d[i] = r[i] / theta;
+    }
+
+    for (int step = 0; step < n_steps; step++) {
+        vec_add(x, d, n);
+        if (step == n_steps - 1) break;
+        spmv_csr(matrix, d, Ad);
+        double rho_new = 1.0 / (2.0 * sigma - rho);
+        vec_sub(r, Ad, n);
+        vec_waxpby(d, rho_new * rho, d, 2.0 * rho_new / delta, r, n);
+        rho = rho_new;
+    }
+
+    free(r);
+    free(d);
+    free(Ad);
+}
+
+/* D^{-1/2} A D^{-1/2}, whose eigenvalues are 1 minus those of the Jacobi iteration matrix. */
+typedef struct {
+    const SparseCSR *matrix;
+    const double *inv_sqrt_diag;
+    double *work;
+} jacobi_scaled_op;
+
+static void jacobi_scaled_apply_op(const void *ctx, const double *x, double *y) {
+    const jacobi_scaled_op *op = (const jacobi_scaled_op *)ctx;
+    int n = op->matrix->rows;
+    for (int i = 0; i < n; i++) {
+        op->work[i] = op->inv_sqrt_diag[i] * x[i];
+    }
+    spmv_csr(op->matrix, op->work, y);
+    for (int i = 0; i < n; i++) {
+        y[i] *= op->inv_sqrt_diag[i];
+    }
+}
+
+/*
+ * Spectral radius of the Jacobi iteration matrix I - D^{-1} A by Lanczos on the
+ * symmetrically scaled matrix; the Ritz values converge much faster than power
+ * iteration on I - D^{-1} A, whose extreme eigenvalues come in +-rho pairs close
+ * to the rest of the spectrum. Returns 1 if a diagonal entry is not positive.
+ */
+static double jacobi_spectral_radius(const SparseCSR *matrix) {
+    int n = matrix->rows;
+    double *inv_sqrt_diag = (double *)malloc(n * sizeof(double));
+    double *work = (double *)malloc(n * sizeof(double));
+    int positive = 1;
+    for (int i = 0; i < n; i++) {
+        double diag = 0.0;
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            if (matrix->col_ind[j] == i) diag += matrix->values[j];
+        }
+        if (diag <= 0.0) positive = 0;
+        inv_sqrt_diag[i] = diag > 0.0 ? 1.0 / sqrt(diag) : 0.0;
+    }
+
+    double rho = 1.0;
+    if (positive && n > 0) {
+        jacobi_scaled_op op = {matrix, inv_sqrt_diag, work};
+        rho = 0.0;
+        for (int steps = SOR_LANCZOS_STEPS; ; steps *= 2) {
+            double lambda_min, lambda_max;
+            lanczos_op(jacobi_scaled_apply_op, &op, matrix, steps, &lambda_min, &lambda_max);
+            double rho_new = fmax(fabs(1.0 - lambda_min), fabs(lambda_max - 1.0));
+            // Ritz values lie inside the spectrum, so rho grows towards its limit
+            int settled = fabs(rho_new - rho) < SOR_LANCZOS_TOL * fabs(1.0 - rho_new);
+            rho = rho_new;
+            if (settled || steps >= n || steps >= SOR_LANCZOS_MAX_STEPS) break;
+        }
+    }
+
+    free(inv_sqrt_diag);
+    free(work);
+    return rho;
+}
+
+double estimate_SOR_omega_csr(const SparseCSR *matrix) {
+    double rho = jacobi_spectral_radius(matrix);
+    if (rho >= 1.0) return 1.0;
+    return 2.0 / (1.0 + sqrt(1.0 - rho * rho));
+}
+
+double estimate_SSOR_omega_csr(const SparseCSR *matrix) {
+    double rho = jacobi_spectral_radius(matrix);
+    if (rho >= 1.0) return 1.0;
+    return 2.0 / (1.0 + sqrt(2.0 * (1.0 - rho)));
+}
+
+/* One SOR sweep over the rows in increasing (forward) or decreasing order; returns the squared update norm. */
+static double sor_sweep(const SparseCSR *matrix, const int *diag_ind, const double *inv_diag, const double *b, double *x, double omega, int forward) {
+    int n = matrix->rows;
+    double norm = 0.0;
+    for (int k = 0; k < n; k++) {
+        int i = forward ? k : n - 1 - k;
+        double dx = omega * ((b[i] - csr_offdiag_row(matrix, diag_ind, i, x)) * inv_diag[i] - x[i]);
+        x[i] += dx;
+        norm += dx * dx;
+    }
+    return norm;
+}
+
+static void SOR(const SparseCSR *matrix, const double *b, double *x, double omega, int symmetric, int max_iter, double tol, int verbose) {
+    const char *name = symmetric ? "SSOR" : "SOR";
+    if (omega <= 0.0) {
+        omega = symmetric ? estimate_SSOR_omega_csr(matrix) : estimate_SOR_omega_csr(matrix);
+    }
+    if (verbose) printf("%s relaxation parameter omega = %.6f\n", name, omega);
+    int *diag_ind = (int *)malloc(matrix->rows * sizeof(int));
+    double *inv_diag = (double *)malloc(matrix->rows * sizeof(double));
+    csr_diagonal_cache(matrix, diag_ind, inv_diag);
+    for (int iter = 0; iter < max_iter; iter++) {
+        double norm = sor_sweep(matrix, diag_ind, inv_diag, b, x, omega, 1);
+        if (symmetric) norm += sor_sweep(matrix, diag_ind, inv_diag, b, x, omega, 0);
+        norm = sqrt(norm);
+        if (verbose) printf("%s Iteration %d: Residual = %e\n", name, iter + 1, norm);
+        if (norm < tol) break;
+    }
+    free(diag_ind);
+    free(inv_diag);
+}
+
+void SOR_csr_debug(const SparseCSR *matrix, const double *b, double *x, double omega, int max_iter, double tol) {
+    SOR(matrix, b, x, omega, 0, max_iter, tol, 1);
+}
+
+void SOR_csr(const SparseCSR *matrix, const double *b, double *x, double omega, int max_iter, double tol) {
+    SOR(matrix, b, x, omega, 0, max_iter, tol, 0);
+}
+
+void SSOR_csr_debug(const SparseCSR *matrix, const double *b, double *x, double omega, int max_iter, double tol) {
+    SOR(matrix, b, x, omega, 1, max_iter, tol, 1);
+}
+
+void SSOR_csr(const SparseCSR *matrix, const double *b, double *x, double omega, int max_iter, double tol) {
+    SOR(matrix, b, x, omega, 1, max_iter, tol, 0);
+}
+
+/* Largest |col - row| over the stored entries. */
+static int csr_bandwidth(const SparseCSR *matrix) {
+    int w = 0;
+    for (int i = 0; i < matrix->rows; i++) {
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            int d = abs(matrix->col_ind[j] - i);
+            if (d > w) w = d;
+        }
+    }
+    return w;
+}
+
+/* V_out[i] = (A*V_in - shift*V_in)[i] / scale for rows [start, end). */
+static void matrix_powers_rows(const SparseCSR *matrix, const double *V_in, double *V_out, double shift, double scale, int start, int end) {
+    for (int i = start; i < end; i++) {
+        double sum = -shift * V_in[i];
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            sum += matrix->values[j] * V_in[matrix->col_ind[j]];
+        }
+        V_out[i] = sum / scale;
+    }
+}
+
+void matrix_powers_csr(const SparseCSR *matrix, const double *v, int s, const double *shifts, const double *scales, double *V) {
+    if (s < 0) return;
+    int n = matrix->rows;
+    int w = csr_bandwidth(matrix);
+    int *done = (int *)calloc(s + 1, sizeof(int));
+
+    vec_copy(V, v, n);
+    done[0] = n;
+
+    // Skewed wavefront over row blocks: level k of row i only needs level k-1 up to row i + w,
+    // so all s levels of one block are computed while the block is still in cache.
+    while (done[s] < n) {
+        for (int k = 1; k <= s; k++) {
+            int limit;
+            if (k == 1) {
+                limit = done[1] + MATRIX_POWERS_BLOCK_ROWS;
+            } else {
+                limit = (done[k - 1] == n) ? n : done[k - 1] - w;
+            }
+            if (limit > n) limit = n;
+            if (limit <= done[k]) continue;
+            double shift = shifts ? shifts[k - 1] : 0.0;
+            double scale = scales ? scales[k - 1] : 1.0;
+            matrix_powers_rows(matrix, V + (size_t)(k - 1) * n, V + (size_t)k * n, shift, scale, done[k], limit);
+            done[k] = limit;
+        }
+    }
+    free(done);
+}
+
+/* Shifts (Leja-ordered Chebyshev points of the spectrum) and scales of the Krylov basis. */
+static void sstep_basis_parameters(const SparseCSR *matrix, int s, krylov_basis_type basis, double *shifts, double *scales) {
+    double lambda_min, lambda_max;
+    Lanczos_eig_bounds_csr(matrix, SSTEP_LANCZOS_STEPS, &lambda_min, &lambda_max);
+
+    if (basis == KRYLOV_BASIS_MONOMIAL) {
+        for (int k = 0; k < s; k++) {
+            shifts[k] = 0.0;
+            scales[k] = lambda_max;
+        }
+        return;
+    }
+
+    double center = 0.5 * (lambda_max + lambda_min);
+    double radius = 0.5 * (lambda_max - lambda_min);
+    double *points = (double *)malloc(s * sizeof(double));
+    int *used = (int *)calloc(s, sizeof(int));
+    for (int k = 0; k < s; k++) {
+        points[k] = center + radius * cos((2 * k + 1) * M_PI / (2 * s));
+    }
+    for (int k = 0; k < s; k++) {
+        int best = -1;
+        double best_val = -1.0;
+        for (int m = 0; m < s; m++) {
+            if (used[m]) continue;
+            double val = (k == 0) ? fabs(points[m]) : 1.0;
+            for (int l = 0; l < k; l++) {
+                val *= fabs(points[m] - shifts[l]);
+            }
+            if (val > best_val) {
+                best_val = val;
+                best = m;
+            }
+        }
+        used[best] = 1;
+        shifts[k] = points[best];
+        scales[k] = (radius > 0.0) ? 0.5 * radius : 1.0;
+    }
+    free(points);
+    free(used);
+}
+
+/* y = Gram quadratic form u^T G v for the (m x m) Gram matrix. */
+static double sstep_gram_form(const double *G, const double *u, const double *v, int m) {
+    double result = 0.0;
+    for (int a = 0; a < m; a++) {
+        double row = 0.0;
+        for (int c = 0; c < m; c++) {
+            row += G[a * m + c] * v[c];
+        }
+        result += u[a] * row;
+    }
+    return result;
+}
+
+static void sstep_CG(const SparseCSR *matrix, const double *b, double *x, int s, krylov_basis_type basis, int max_iter, double tol, int verbose) {
+    // A block of s = 0 iterations would never advance
+    if (s < 1) return;
+    int n = matrix->rows;
+    int m = 2 * s + 1;
+    double *r = (double *)malloc(n * sizeof(double));
+    double *p = (double *)malloc(n * sizeof(double));
+    double *Y = (double *)malloc((size_t)m * n * sizeof(double));
+    double *G = (double *)malloc(m * m * sizeof(double));
+    double *B = (double *)calloc(m * m, sizeof(double));
+    double *shifts = (double *)malloc(s * sizeof(double));
+    double *scales = (double *)malloc(s * sizeof(double));
+    double *pc = (double *)malloc(m * sizeof(double));
+    double *rc = (double *)malloc(m * sizeof(double));
+    double *xc = (double *)malloc(m * sizeof(double));
+    double *Bp = (double *)malloc(m * sizeof(double));
+    const double **Y_cols = (const double **)malloc(m * sizeof(double *));
+    for (int a = 0; a < m; a++) {
+        Y_cols[a] = Y + (size_t)a * n;
+    }
+
+    sstep_basis_parameters(matrix, s, basis, shifts, scales);
+    // A * Y[:, j] = scales[j] * Y[:, j + 1] + shifts[j] * Y[:, j] inside each block
+    for (int j = 0; j < s; j++) {
+        B[j * m + j] = shifts[j];
+        B[(j + 1) * m + j] = scales[j];
+        if (j < s - 1) {
+            B[(s + 1 + j) * m + (s + 1 + j)] = shifts[j];
+            B[(s + 2 + j) * m + (s + 1 + j)] = scales[j];
+        }
+    }
+
+    // r = b - A*x
+    csr_solve_decoupled_rows(matrix, b, x);
+    spmv_csr(matrix, x, r);
+    for (int i = 0; i < n; i++) {
+        r[i] = b[i] - r[i];
+        p[i] = r[i];
+    }
+
+    int iter = 0;
+    int converged = vec_norm2(r, n) < tol;
+    while (!converged && iter < max_iter) {
+        // Krylov basis [P | R] of the block: one matrix-powers call each
+        matrix_powers_csr(matrix, p, s, shifts, scales, Y);
+        matrix_powers_csr(matrix, r, s - 1, shifts, scales, Y + (size_t)(s + 1) * n);
+
+        // One block reduction per s iterations: G = Y^T Y, row a from one vec_mdot pass over Y[:, a]
+        for (int a = 0; a < m; a++) {
+            vec_mdot(Y + (size_t)a * n, Y_cols + a, m - a, n, G + a * m + a);
+        }
+        for (int a = 0; a < m; a++) {
+            for (int c = 0; c < a; c++) {
+                G[a * m + c] = G[c * m + a];
+            }
+        }
+
+        for (int a = 0; a < m; a++) {
+            pc[a] = rc[a] = xc[a] = 0.0;
+        }
+        pc[0] = 1.0;
+        rc[s + 1] = 1.0;
+        double rsold = sstep_gram_form(G, rc, rc, m);
+
+        for (int j = 0; j < s && iter < max_iter; j++) {
+            for (int a = 0; a < m; a++) {
+                Bp[a] = 0.0;
+                for (int c = 0; c < m; c++) {
+                    Bp[a] += B[a * m + c] * pc[c];
+                }
+            }
+            double alpha = rsold / sstep_gram_form(G, pc, Bp, m);
+            for (int a = 0; a < m; a++) {
+                xc[a] += alpha * pc[a];
+                rc[a] -= alpha * Bp[a];
+            }
+            double rsnew = sstep_gram_form(G, rc, rc, m);
+            iter++;
+
+            if (verbose) printf("s-step CG Iteration %d: Residual = %e\n", iter, sqrt(fabs(rsnew)));
+            if (sqrt(fabs(rsnew)) < tol) {
+                converged = 1;
+                break;
+            }
+
+            double beta = rsnew / rsold;
+            for (int a = 0; a < m; a++) {
+                pc[a] = rc[a] + beta * pc[a];
+            }
+            rsold = rsnew;
+        }
+
+        // Map the coordinates back: x += Y xc, r = Y rc, p = Y pc
+        for (int i = 0; i < n; i++) {
+            double dx = 0.0, ri = 0.0, pi = 0.0;
+            for (int a = 0; a < m; a++) {
+                double y = Y[(size_t)a * n + i];
+                dx += y * xc[a];
+                ri += y * rc[a];
+                pi += y * pc[a];
+            }
+            x[i] += dx;
+            r[i] = ri;
+            p[i] = pi;
+        }
+    }
+
+    free(r);
+    free(p);
+    free(Y);
+    free(G);
+    free(B);
+    free(shifts);
+    free(scales);
+    free(pc);
+    free(rc);
+    free(xc);
+    free(Bp);
+    free(Y_cols);
+}
+
+void sstep_CG_csr_debug(const SparseCSR *matrix, const double *b, double *x, int s, krylov_basis_type basis, int max_iter, double tol) {
+    sstep_CG(matrix, b, x, s, basis, max_iter, tol, 1);
+}
+
+void sstep_CG_csr(const SparseCSR *matrix, const double *b, double *x, int s, krylov_basis_type basis, int max_iter, double tol) {
+    sstep_CG(matrix, b, x, s, basis, max_iter, tol, 0);
+}
+
+RecycleSpace* createRecycleSpace(int n, int k, int m) {
+    RecycleSpace *space = (RecycleSpace *)malloc(sizeof(RecycleSpace));
+    space->n = n;
+    space->k = k;
+    space->m = m;
+    space->n_vec = 0;
+    space->n_dir = 0;
+    space->W = (double *)malloc((size_t)(k + m) * n * sizeof(double));
+    space->AW = (double *)malloc((size_t)(k + m) * n * sizeof(double));
+    space->refresh_period = RECYCLE_REFRESH_PERIOD;
+    space->n_solves = 0;
+    space->base_iter = -1;
+    space->stale = 0;
+    return space;
+}
+
+void freeRecycleSpace(RecycleSpace *space) {
+    if (space) {
+        free(space->W);
+        free(space->AW);
+        free(space);
+    }
+}
+
+/* Cyclic Jacobi eigenvalue method for a small dense symmetric matrix (row-major, overwritten). */
+static void dense_symmetric_eigen(double *S, int m, double *eigval, double *eigvec) {
+    for (int a = 0; a < m; a++) {
+        for (int c = 0; c < m; c++) {
+            eigvec[a * m + c] = (a == c) ? 1.0 : 0.0;
+        }
+    }
+    for (int sweep = 0; sweep < 100; sweep++) {
+        double off = 0.0, diag = 0.0;
+        for (int a = 0; a < m; a++) {
+            diag += S[a * m + a] * S[a * m + a];
+            for (int c = a + 1; c < m; c++) {
+                off += S[a * m + c] * S[a * m + c];
+            }
+        }
+        if (off <= 1e-30 * diag) break;
+        for (int p = 0; p < m; p++) {
+            for (int q = p + 1; q < m; q++) {
+                double apq = S[p * m + q];
+                if (apq == 0.0) continue;
+                double theta = (S[q * m + q] - S[p * m + p]) / (2.0 * apq);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0), sn = t * c;
+                for (int l = 0; l < m; l++) {
+                    double slp = S[l * m + p], slq = S[l * m + q];
+                    S[l * m + p] = c * slp - sn * slq;
+                    S[l * m + q] = sn * slp + c * slq;
+                }
+                for (int l = 0; l < m; l++) {
+                    double spl = S[p * m + l], sql = S[q * m + l];
+                    S[p * m + l] = c * spl - sn * sql;
+                    S[q * m + l] = sn * spl + c * sql;
+                }
+                for (int l = 0; l < m; l++) {
+                    double vlp = eigvec[l * m + p], vlq = eigvec[l * m + q];
+                    eigvec[l * m + p] = c * vlp - sn * vlq;
+                    eigvec[l * m + q] = sn * vlp + c * vlq;
+                }
+            }
+        }
+    }
+    for (int a = 0; a < m; a++) {
+        eigval[a] = S[a * m + a];
+    }
+}
+
+/*
+ * Rayleigh-Ritz on Z = [W, P]: A-orthonormalize the columns, then keep the k Ritz
+ * vectors of the smallest eigenvalues. With Z^T A Z = I these are the eigenvectors
+ * of the largest eigenvalues of Z^T Z.
+ */
+static void recycle_space_update(RecycleSpace *space) {
+    int n = space->n;
+    int total = space->n_vec + space->n_dir;
+    double *Z = space->W, *AZ = space->AW;
+
+    int kept = 0;
+    for (int c = 0; c < total; c++) {
+        double *z = Z + (size_t)c * n, *Az = AZ + (size_t)c * n;
+        double norm0 = sqrt(fabs(vec_dot(z, Az, n)));
+        for (int pass = 0; pass < 2; pass++) {
+            for (int q = 0; q < kept; q++) {
+                double coef = vec_dot(AZ + (size_t)q * n, z, n);
+                vec_axpy(z, -coef, Z + (size_t)q * n, n);
+                vec_axpy(Az, -coef, AZ + (size_t)q * n, n);
+            }
+        }
+        double norm = sqrt(fabs(vec_dot(z, Az, n)));
+        if (norm <= 1e-10 * norm0 || norm == 0.0) continue;
+        double *zk = Z + (size_t)kept * n, *Azk = AZ + (size_t)kept * n;
+        for (int i = 0; i < n; i++) {
+            zk[i] = z[i] / norm;
+            Azk[i] = Az[i] / norm;
+        }
+        kept++;
+    }
+
+    int k = (kept < space->k) ? kept : space->k;
+    double *S = (double *)malloc(kept * kept * sizeof(double));
+    double *eigval = (double *)malloc(kept * sizeof(double));
+    double *eigvec = (double *)malloc(kept * kept * sizeof(double));
+    int *order = (int *)malloc(kept * sizeof(int));
+    double *newW = (double *)calloc((size_t)k * n, sizeof(double));
+    double *newAW = (double *)calloc((size_t)k * n, sizeof(double));
+    for (int a = 0; a < kept; a++) {
+        for (int c = a; c < kept; c++) {
+            S[a * kept + c] = S[c * kept + a] = vec_dot(Z + (size_t)a * n, Z + (size_t)c * n, n);
+        }
+    }
+    dense_symmetric_eigen(S, kept, eigval, eigvec);
+    for (int a = 0; a < kept; a++) {
+        order[a] = a;
+    }
+    for (int a = 0; a < k; a++) {
+        for (int c = a + 1; c < kept; c++) {
+            if (eigval[order[c]] > eigval[order[a]]) {
+                int tmp = order[a];
+                order[a] = order[c];
+                order[c] = tmp;
+            }
+        }
+    }
+    for (int a = 0; a < k; a++) {
+        for (int c = 0; c < kept; c++) {
+            double y = eigvec[c * kept + order[a]];
+            vec_axpy(newW + (size_t)a * n, y, Z + (size_t)c * n, n);
+            vec_axpy(newAW + (size_t)a * n, y, AZ + (size_t)c * n, n);
+        }
+    }
+    vec_copy(space->W, newW, k * n);
+    vec_copy(space->AW, newAW, k * n);
+    space->n_vec = k;
+    space->n_dir = 0;
+
+    free(S);
+    free(eigval);
+    free(eigvec);
+    free(order);
+    free(newW);
+    free(newAW);
+}
+
+/* v -= W * (AW^T u), i.e. the A-orthogonal projection onto the complement of span(W). */
+static void recycle_space_project(const RecycleSpace *space, const double *u, double *v, double *coef) {
+    int n = space->n;
+    const double **AW = (const double **)malloc((space->n_vec > 0 ? space->n_vec : 1) * sizeof(double *));
+    for (int q = 0; q < space->n_vec; q++) {
+        AW[q] = space->AW + (size_t)q * n;
+    }
+    vec_mdot(u, AW, space->n_vec, n, coef);
+    for (int q = 0; q < space->n_vec; q++) {
+        vec_axpy(v, -coef[q], space->W + (size_t)q * n, n);
+    }
+    free(AW);
+}
+
+static int deflated_CG(const SparseCSR *matrix, const double *b, double *x, RecycleSpace *space, int max_iter, double tol, int verbose) {
+    int n = matrix->rows;
+    double *r = (double *)malloc(n * sizeof(double));
+    double *p = (double *)malloc(n * sizeof(double));
+    double *Ap = (double *)malloc(n * sizeof(double));
+    double *coef = (double *)malloc((space->k + 1) * sizeof(double));
+
+    // r = b - A*x
+    csr_solve_decoupled_rows(matrix, b, x);
+    spmv_axpby_csr(matrix, -1.0, x, 0.0, r, b);
+
+    // Galerkin correction on span(W): x += W W^T r, r -= AW W^T r
+    for (int q = 0; q < space->n_vec; q++) {
+        const double *w = space->W + (size_t)q * n, *Aw = space->AW + (size_t)q * n;
+        double c = vec_dot(w, r, n);
+        vec_axpy(x, c, w, n);
+        vec_axpy(r, -c, Aw, n);
+    }
+
+    vec_copy(p, r, n);
+    recycle_space_project(space, r, p, coef);
+    double rsold = vec_dot(r, r, n);
+
+    // Rebuilding the space is expensive: only refresh when it is empty, due or no longer effective
+    int refresh = space->m > 0 && (space->n_vec == 0 || space->stale || space->n_solves >= space->refresh_period);
+    space->n_dir = 0;
+
+    int iter = 0;
+    if (sqrt(rsold) >= tol) {
+        for (iter = 0; iter < max_iter; iter++) {
+            spmv_csr(matrix, p, Ap);
+            double pAp = vec_dot(p, Ap, n);
+            double alpha = rsold / pAp;
+
+            // Harvest the first search directions of the solve for the next update
+            if (refresh && space->n_dir < space->m && pAp > 0.0) {
+                int slot = space->n_vec + space->n_dir;
+                vec_copy(space->W + (size_t)slot * n, p, n);
+                vec_copy(space->AW + (size_t)slot * n, Ap, n);
+                space->n_dir++;
+            }
+
+            vec_axpy(x, alpha, p, n);
+            vec_axpy(r, -alpha, Ap, n);
+
+            double rsnew = vec_dot(r, r, n);
+            if (verbose) printf("Deflated CG Iteration %d: Residual = %e\n", iter + 1, sqrt(rsnew));
+            if (sqrt(rsnew) < tol) {
+                iter++;
+                break;
+            }
+
+            double beta = rsnew / rsold;
+            vec_waxpby(p, 1.0, r, beta, p, n);
+            recycle_space_project(space, r, p, coef);
+            rsold = rsnew;
+        }
+    }
+
+    if (refresh && space->n_dir > 0) {
+        recycle_space_update(space);
+        space->n_solves = 0;
+        space->base_iter = -1;
+        space->stale = 0;
+    } else if (!refresh) {
+        space->n_solves++;
+        if (space->base_iter < 0) {
+            space->base_iter = iter;
+        } else if (4 * iter > 5 * space->base_iter + 4) {
+            space->stale = 1;
+        }
+    }
+
+    free(r);
+    free(p);
+    free(Ap);
+    free(coef);
+    return iter;
+}
+
+int deflated_CG_csr_debug(const SparseCSR *matrix, const double *b, double *x, RecycleSpace *space, int max_iter, double tol) {
+    return deflated_CG(matrix, b, x, space, max_iter, tol, 1);
+}
+
+int deflated_CG_csr(const SparseCSR *matrix, const double *b, double *x, RecycleSpace *space, int max_iter, double tol) {
+    return deflated_CG(matrix, b, x, space, max_iter, tol, 0);
+}
+
+SparseCSR* transpose_csr(const SparseCSR *matrix) {
+    int rows = matrix->rows, cols = matrix->cols;
+    SparseCSR *T = createSparseCSR(cols, rows, matrix->nnz);
+    int n_threads = csr_max_threads();
+    // counts[t * (cols + 1) + c]: entries of column c in the row chunk of thread t
+    int *counts = (int *)calloc((size_t)n_threads * (cols + 1), sizeof(int));
+
+    #pragma omp parallel num_threads(n_threads)
+    {
+        int t = csr_thread_id();
+        int team = csr_num_threads();
+        int chunk = (rows + team - 1) / team;
+        int start = t * chunk, end = (start + chunk < rows) ? start + chunk : rows;
+        int *count = counts + (size_t)t * (cols + 1);
+        for (int i = start; i < end; i++) {
+            for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+                count[matrix->col_ind[j]]++;
+            }
+        }
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            // Offsets ordered by (column, thread), so rows of T stay sorted by source row
+            int offset = 0;
+            for (int c = 0; c < cols; c++) {
+                T->row_ptr[c] = offset;
+                for (int s = 0; s < n_threads; s++) {
+                    int cnt = counts[(size_t)s * (cols + 1) + c];
+                    counts[(size_t)s * (cols + 1) + c] = offset;
+                    offset += cnt;
+                }
+            }
+            T->row_ptr[cols] = offset;
+        }
+
+        for (int i = start; i < end; i++) {
+            for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+                int pos = count[matrix->col_ind[j]]++;
+                T->col_ind[pos] = i;
+                T->values[pos] = matrix->values[j];
+            }
+        }
+    }
+
+    free(counts);
+    return T;
+}
+
+SparseCSR* spgemm_symbolic_csr(const SparseCSR *A, const SparseCSR *B) {
+    int rows = A->rows, cols = B->cols;
+    int *row_ptr = (int *)malloc((rows + 1) * sizeof(int));
+    int n_threads = csr_max_threads();
+
+    // Pass 1: count the distinct columns of every row of C
+    #pragma omp parallel num_threads(n_threads)
+    {
+        int *marker = (int *)malloc(cols * sizeof(int));
+        for (int c = 0; c < cols; c++) marker[c] = -1;
+        #pragma omp for schedule(dynamic, 256)
+        for (int i = 0; i < rows; i++) {
+            int count = 0;
+            for (int ja = A->row_ptr[i]; ja < A->row_ptr[i + 1]; ja++) {
+                int k = A->col_ind[ja];
+                for (int jb = B->row_ptr[k]; jb < B->row_ptr[k + 1]; jb++) {
+                    int c = B->col_ind[jb];
+                    if (marker[c] != i) {
+                        marker[c] = i;
+                        count++;
+                    }
+                }
+            }
+            row_ptr[i + 1] = count;
+        }
+        free(marker);
+    }
+
+    row_ptr[0] = 0;
+    for (int i = 0; i < rows; i++) {
+        row_ptr[i + 1] += row_ptr[i];
+    }
+    SparseCSR *C = createSparseCSR(rows, cols, row_ptr[rows]);
+    free(C->row_ptr);
+    C->row_ptr = row_ptr;
+
+    // Pass 2: fill the (sorted) column indices
+    #pragma omp parallel num_threads(n_threads)
+    {
+        int *marker = (int *)malloc(cols * sizeof(int));
+        for (int c = 0; c < cols; c++) marker[c] = -1;
+        #pragma omp for schedule(dynamic, 256)
+        for (int i = 0; i < rows; i++) {
+            int idx = C->row_ptr[i];
+            for (int ja = A->row_ptr[i]; ja < A->row_ptr[i + 1]; ja++) {
+                int k = A->col_ind[ja];
+                for (int jb = B->row_ptr[k]; jb < B->row_ptr[k + 1]; jb++) {
+                    int c = B->col_ind[jb];
+                    if (marker[c] != i) {
+                        marker[c] = i;
+                        C->col_ind[idx++] = c;
+                    }
+                }
+            }
+            for (int j = C->row_ptr[i] + 1; j < C->row_ptr[i + 1]; j++) {
+                int c = C->col_ind[j];
+                int m = j - 1;
+                while (m >= C->row_ptr[i] && C->col_ind[m] > c) {
+                    C->col_ind[m + 1] = C->col_ind[m];
+                    m--;
+                }
+                C->col_ind[m + 1] = c;
+            }
+            for (int j = C->row_ptr[i]; j < C->row_ptr[i + 1]; j++) {
+                C->values[j] = 0.0;
+            }
+        }
+        free(marker);
+    }
+    return C;
+}
+
+void spgemm_numeric_csr(const SparseCSR *A, const SparseCSR *B, SparseCSR *C) {
+    int rows = A->rows, cols = B->cols;
+
+    #pragma omp parallel
+    {
+        // pos[c]: index of column c in the current row of C, -1 otherwise
+        int *pos = (int *)malloc(cols * sizeof(int));
+        for (int c = 0; c < cols; c++) pos[c] = -1;
+        #pragma omp for schedule(dynamic, 256)
+        for (int i = 0; i < rows; i++) {
+            for (int j = C->row_ptr[i]; j < C->row_ptr[i + 1]; j++) {
+                pos[C->col_ind[j]] = j;
+                C->values[j] = 0.0;
+            }
+            for (int ja = A->row_ptr[i]; ja < A->row_ptr[i + 1]; ja++) {
+                int k = A->col_ind[ja];
+                double a = A->values[ja];
+                for (int jb = B->row_ptr[k]; jb < B->row_ptr[k + 1]; jb++) {
+                    C->values[pos[B->col_ind[jb]]] += a * B->values[jb];
+                }
+            }
+            for (int j = C->row_ptr[i]; j < C->row_ptr[i + 1]; j++) {
+                pos[C->col_ind[j]] = -1;
+            }
+        }
+        free(pos);
+    }
+}
+
+SparseCSR* spgemm_csr(const SparseCSR *A, const SparseCSR *B) {
+    SparseCSR *C = spgemm_symbolic_csr(A, B);
+    spgemm_numeric_csr(A, B, C);
+    return C;
+}
+
+static void PCG(const SparseCSR *matrix, const double *b, double *x, precond_func precond, const void *ctx, int max_iter, double tol, int verbose) {
+    int n = matrix->rows;
+    double *r = (double *)malloc(n * sizeof(double));
+    double *z = (double *)malloc(n * sizeof(double));
+    double *p = (double *)malloc(n * sizeof(double));
+    double *Ap = (double *)malloc(n * sizeof(double));
+
+    // r = b - A*x
+    csr_solve_decoupled_rows(matrix, b, x);
+    spmv_axpby_csr(matrix, -1.0, x, 0.0, r, b);
+    if (precond) precond(ctx, r, z);
+    else vec_copy(z, r, n);
+    vec_copy(p, z, n);
+
+    double rzold = vec_dot(r, z, n);
+    // One residual norm per iteration: the one checked after the update guards the next step
+    double rnorm = vec_norm2(r, n);
+
+    for (int iter = 0; iter < max_iter && rnorm >= tol; iter++) {
+        spmv_csr(matrix, p, Ap);
+        double alpha = rzold / vec_dot(p, Ap, n);
+
+        vec_axpy(x, alpha, p, n);
+        vec_axpy(r, -alpha, Ap, n);
+
+        rnorm = vec_norm2(r, n);
+        if (verbose) printf("PCG Iteration %d: Residual = %e\n", iter + 1, rnorm);
+        if (rnorm < tol) break;
+
+        if (precond) precond(ctx, r, z);
+        else vec_copy(z, r, n);
+        double rznew = vec_dot(r, z, n);
+        vec_waxpby(p, 1.0, z, rznew / rzold, p, n);
+        rzold = rznew;
+    }
+
+    free(r);
+    free(z);
+    free(p);
+    free(Ap);
+}
+
+void PCG_csr_debug(const SparseCSR *matrix, const double *b, double *x, precond_func precond, const void *ctx, int max_iter, double tol) {
+    PCG(matrix, b, x, precond, ctx, max_iter, tol, 1);
+}
+
+void PCG_csr(const SparseCSR *matrix, const double *b, double *x, precond_func precond, const void *ctx, int max_iter, double tol) {
+    PCG(matrix, b, x, precond, ctx, max_iter, tol, 0);
+}
@@ -0,0 +1,66 @@
+/**
+ * @file csrf.c
+ * @brief Implementation of CSR matrices with single-precision values.
+ *
+ * This file includes the conversion from SparseCSR, the mixed-precision
+ * matrix-vector product (float values, double vectors and accumulation) and the
+ * rounding check of the values.
+ * @see csrf.h
+ * @author Li Zhijun
+ * @date 2025-12-18
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "csrf.h"
+
+SparseCSRf* createSparseCSRf(const SparseCSR *matrix) {
+    SparseCSRf *result = (SparseCSRf *)malloc(sizeof(SparseCSRf));
+    result->rows = matrix->rows;
+    result->cols = matrix->cols;
+    result->nnz = matrix->nnz;
+    result->row_ptr = (int *)malloc((matrix->rows + 1) * sizeof(int));
+    result->col_ind = (int *)malloc(matrix->nnz * sizeof(int));
+    result->values = (float *)malloc(matrix->nnz * sizeof(float));
+    memcpy(result->row_ptr, matrix->row_ptr, (matrix->rows + 1) * sizeof(int));
+    memcpy(result->col_ind, matrix->col_ind, matrix->nnz * sizeof(int));
+    for (int k = 0; k < matrix->nnz; k++) {
+        result->values[k] = (float)matrix->values[k];
+    }
+    return result;
+}
+
+void freeSparseCSRf(SparseCSRf *matrix) {
+    if (matrix) {
+        free(matrix->row_ptr);
+        free(matrix->col_ind);
+        free(matrix->values);
+        free(matrix);
+    }
+}
+
+void spmv_csrf(const SparseCSRf *matrix, const double *x, double *y) {
+    const int *row_ptr = matrix->row_ptr;
+    const int *col_ind = matrix->col_ind;
+    const float *values = matrix->values;
+    #pragma omp parallel for schedule(static) if (matrix->nnz >= CSR_PARALLEL_MIN_NNZ)
+    for (int i = 0; i < matrix->rows; i++) {
+        double sum = 0.0;
+        for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            sum += (double)values[k] * x[col_ind[k]];
+        }
+        y[i] = sum;
+    }
+}
+
+double float_rounding_csr(const SparseCSR *matrix) {
+    double max_rounding = 0.0;
+    for (int k = 0; k < matrix->nnz; k++) {
+        double value = matrix->values[k];
+        if (value == 0.0) continue;
+        double rounding = fabs(value - (double)(float)value) / fabs(value);
+        if (isinf((float)value)) rounding = INFINITY;
+        if (rounding > max_rounding) max_rounding = rounding;
+    }
+    return max_rounding;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file csrv.c
+ * @brief Implementation of value-indexed CSR matrices.
+ *
+ * This file includes the extraction of the value table from a SparseCSR, the
+ * conversion into SparseCSRv and its matrix-vector product.
+ * @see csrv.h
+ * @author Li Zhijun
+ * @date 2025-12-19
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "csrv.h"
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Sorted distinct values of the matrix in a newly allocated array. */
+static double* distinct_values(const SparseCSR *matrix, int *n_values) {
+    double *sorted = (double *)malloc((matrix->nnz > 0 ? matrix->nnz : 1) * sizeof(double));
+    memcpy(sorted, matrix->values, matrix->nnz * sizeof(double));
+    qsort(sorted, matrix->nnz, sizeof(double), compare_double);
+    int n = 0;
+    for (int k = 0; k < matrix->nnz; k++) {
+        if (n == 0 || sorted[k] != sorted[n - 1]) sorted[n++] = sorted[k];
+    }
+    *n_values = n;
+    return sorted;
+}
+
+int count_values_csr(const SparseCSR *matrix) {
+    int n_values;
+    free(distinct_values(matrix, &n_values));
+    return n_values;
+}
+
+SparseCSRv* createSparseCSRv(const SparseCSR *matrix) {
+    int n_values;
+    double *values = distinct_values(matrix, &n_values);
+    if (n_values > CSRV_MAX_VALUES) {
+        free(values);
+        return NULL;
+    }
+    SparseCSRv *result = (SparseCSRv *)malloc(sizeof(SparseCSRv));
+    result->rows = matrix->rows;
+    result->cols = matrix->cols;
+    result->nnz = matrix->nnz;
+    result->row_ptr = (int *)malloc((matrix->rows + 1) * sizeof(int));
+    result->col_ind = (int *)malloc(matrix->nnz * sizeof(int));
+    result->value_ind = (unsigned char *)malloc(matrix->nnz * sizeof(unsigned char));
+    result->n_values = n_values;
+    result->table = values;
+    memcpy(result->row_ptr, matrix->row_ptr, (matrix->rows + 1) * sizeof(int));
+    memcpy(result->col_ind, matrix->col_ind, matrix->nnz * sizeof(int));
+    for (int k = 0; k < matrix->nnz; k++) {
+        // binary search, the table is sorted and tiny
+        int lo = 0, hi = n_values - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (values[mid] < matrix->values[k]) lo = mid + 1;
+            else hi = mid;
+        }
+        result->value_ind[k] = (unsigned char)lo;
+    }
+    return result;
+}
+
+void freeSparseCSRv(SparseCSRv *matrix) {
+    if (matrix) {
+        free(matrix->row_ptr);
+        free(matrix->col_ind);
+        free(matrix->value_ind);
+        free(matrix->table);
+        free(matrix);
+    }
+}
+
+void spmv_csrv(const SparseCSRv *matrix, const double *x, double *y) {
+    const int *row_ptr = matrix->row_ptr;
+    const int *col_ind = matrix->col_ind;
+    const unsigned char *value_ind = matrix->value_ind;
+    const double *table = matrix->table;
+    #pragma omp parallel for schedule(static) if (matrix->nnz >= CSR_PARALLEL_MIN_NNZ)
+    for (int i = 0; i < matrix->rows; i++) {
+        double sum = 0.0;
+        for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            sum += table[value_ind[k]] * x[col_ind[k]];
+        }
+        y[i] = sum;
+    }
+}
@@ -0,0 +1,212 @@
+/**
+ * @file ldlt.c
+ * @brief Implementation of the sparse direct LDL^T factorization.
+ *
+ * This file implements an up-looking sparse LDL^T factorization: the
+ * elimination tree and column counts are computed first (symbolic phase), then
+ * every row of L is obtained from a sparse triangular solve whose pattern is
+ * read off the elimination tree (numeric phase).
+ * @see ldlt.h
+ * @author Li Zhijun
+ * @date 2025-12-12
+ */
+#include <stdlib.h>
+#include "ldlt.h"
+
+static int ldl_is_decoupled_row(const SparseCSR *matrix, int i) {
+    return matrix->row_ptr[i + 1] - matrix->row_ptr[i] == 1 && matrix->col_ind[matrix->row_ptr[i]] == i;
+}
+
+/* Elimination tree and column pointers of L. */
+static void ldl_symbolic(SparseLDL *ldl) {
+    const SparseCSR *matrix = ldl->matrix;
+    int n = ldl->n;
+    int *flag = (int *)malloc(n * sizeof(int));
+    int *lnz = (int *)malloc(n * sizeof(int));
+
+    for (int k = 0; k < n; k++) {
+        ldl->parent[k] = -1;
+        flag[k] = k;
+        lnz[k] = 0;
+        int row = ldl->perm[k];
+        for (int p = matrix->row_ptr[row]; p < matrix->row_ptr[row + 1]; p++) {
+            int i = ldl->iperm[matrix->col_ind[p]];
+            if (i < 0 || i >= k) continue;
+            // Walk up the elimination tree from i to the root of the current subtree
+            for (; flag[i] != k; i = ldl->parent[i]) {
+                if (ldl->parent[i] == -1) ldl->parent[i] = k;
+                lnz[i]++;
+                flag[i] = k;
+            }
+        }
+    }
+    ldl->Lp[0] = 0;
+    for (int k = 0; k < n; k++) {
+        ldl->Lp[k + 1] = ldl->Lp[k] + lnz[k];
+    }
+    free(flag);
+    free(lnz);
+}
+
+static int ldl_numeric(SparseLDL *ldl) {
+    const SparseCSR *matrix = ldl->matrix;
+    int n = ldl->n;
+    double *Y = (double *)calloc(n, sizeof(double));
+    int *pattern = (int *)malloc(n * sizeof(int));
+    int *flag = (int *)malloc(n * sizeof(int));
+    int *lnz = (int *)malloc(n * sizeof(int));
+    int status = 0;
+
+    for (int k = 0; k < n; k++) {
+        int top = n;
+        flag[k] = k;
+        lnz[k] = 0;
+        int row = ldl->perm[k];
+
+        // Scatter row k of the permuted lower triangle and find the pattern of row k of L
+        for (int p = matrix->row_ptr[row]; p < matrix->row_ptr[row + 1]; p++) {
+            int i = ldl->iperm[matrix->col_ind[p]];
+            if (i < 0 || i > k) continue;
+            Y[i] += matrix->values[p];
+            int len = 0;
+            for (; flag[i] != k; i = ldl->parent[i]) {
+                pattern[len++] = i;
+                flag[i] = k;
+            }
+            while (len > 0) {
+                pattern[--top] = pattern[--len];
+            }
+        }
+
+        // Sparse triangular solve for row k of L
+        ldl->D[k] = Y[k];
+        Y[k] = 0.0;
+        for (; top < n; top++) {
+            int i = pattern[top];
+            double yi = Y[i];
+            Y[i] = 0.0;
+            int p2 = ldl->Lp[i] + lnz[i];
+            for (int p = ldl->Lp[i]; p < p2; p++) {
+                Y[ldl->Li[p]] -= ldl->Lx[p] * yi;
+            }
+            double l_ki = yi / ldl->D[i];
+            ldl->D[k] -= l_ki * yi;
+            ldl->Li[p2] = k;
+            ldl->Lx[p2] = l_ki;
+            lnz[i]++;
+        }
+        if (ldl->D[k] == 0.0) {
+            status = -1;
+            break;
+        }
+    }
+
+    free(Y);
+    free(pattern);
+    free(flag);
+    free(lnz);
+    return status;
+}
+
+SparseLDL* createSparseLDL(const SparseCSR *matrix, const int *perm) {
+    int rows = matrix->rows;
+    SparseLDL *ldl = (SparseLDL *)malloc(sizeof(SparseLDL));
+    ldl->matrix = matrix;
+    ldl->iperm = (int *)malloc(rows * sizeof(int));
+    ldl->perm = (int *)malloc(rows * sizeof(int));
+    ldl->work = (double *)malloc(rows * sizeof(double));
+
+    int n = 0;
+    for (int k = 0; k < rows; k++) {
+        int i = perm ? perm[k] : k;
+        if (ldl_is_decoupled_row(matrix, i)) {
+            ldl->iperm[i] = -1;
+        } else {
+            ldl->perm[n] = i;
+            ldl->iperm[i] = n++;
+        }
+    }
+    ldl->n = n;
+    ldl->parent = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    ldl->Lp = (int *)malloc((n + 1) * sizeof(int));
+    ldl->D = (double *)malloc((n > 0 ? n : 1) * sizeof(double));
+
+    ldl_symbolic(ldl);
+    ldl->Li = (int *)malloc((ldl->Lp[n] > 0 ? ldl->Lp[n] : 1) * sizeof(int));
+    ldl->Lx = (double *)malloc((ldl->Lp[n] > 0 ? ldl->Lp[n] : 1) * sizeof(double));
+
+    if (ldl_numeric(ldl) != 0) {
+        freeSparseLDL(ldl);
+        return NULL;
+    }
+    return ldl;
+}
+
+int refactorSparseLDL(SparseLDL *ldl, const SparseCSR *matrix) {
+    ldl->matrix = matrix;
+    return ldl_numeric(ldl);
+}
+
+void solveSparseLDL(const SparseLDL *ldl, const double *b, double *x) {
+    const SparseCSR *matrix = ldl->matrix;
+    int rows = matrix->rows;
+    int n = ldl->n;
+    double *y = ldl->work;
+
+    // Dirichlet rows first, then move their columns to the right-hand side
+    for (int i = 0; i < rows; i++) {
+        if (ldl->iperm[i] < 0) {
+            y[i] = b[i] / matrix->values[matrix->row_ptr[i]];
+        }
+    }
+    for (int k = 0; k < n; k++) {
+        int row = ldl->perm[k];
+        double sum = b[row];
+        for (int p = matrix->row_ptr[row]; p < matrix->row_ptr[row + 1]; p++) {
+            int col = matrix->col_ind[p];
+            if (ldl->iperm[col] < 0) sum -= matrix->values[p] * y[col];
+        }
+        x[row] = sum;
+    }
+    for (int i = 0; i < rows; i++) {
+        if (ldl->iperm[i] < 0) x[i] = y[i];
+    }
+
+    // L z = P b, D w = z, L^T v = w, x = P^T v (in the permuted workspace y)
+    for (int k = 0; k < n; k++) {
+        y[k] = x[ldl->perm[k]];
+    }
+    for (int j = 0; j < n; j++) {
+        double yj = y[j];
+        for (int p = ldl->Lp[j]; p < ldl->Lp[j + 1]; p++) {
+            y[ldl->Li[p]] -= ldl->Lx[p] * yj;
+        }
+    }
+    for (int j = 0; j < n; j++) {
+        y[j] /= ldl->D[j];
+    }
+    for (int j = n - 1; j >= 0; j--) {
+        double yj = y[j];
+        for (int p = ldl->Lp[j]; p < ldl->Lp[j + 1]; p++) {
+            yj -= ldl->Lx[p] * y[ldl->Li[p]];
+        }
+        y[j] = yj;
+    }
+    for (int k = 0; k < n; k++) {
+        x[ldl->perm[k]] = y[k];
+    }
+}
+
+void freeSparseLDL(SparseLDL *ldl) {
+    if (ldl) {
+        free(ldl->perm);
+        free(ldl->iperm);
+        free(ldl->parent);
+        free(ldl->Lp);
+        free(ldl->Li);
+        free(ldl->Lx);
+        free(ldl->D);
+        free(ldl->work);
+        free(ldl);
+    }
+}
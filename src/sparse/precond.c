@@ -0,0 +1,496 @@
+/**
+ * @file precond.c
+ * @brief Implementation of preconditioners and level-scheduled triangular solves.
+ *
+ * This file includes the construction of level schedules for sparse triangular
+ * solves, the OpenMP-parallel solves over those schedules, the ILU(0) and SSOR
+ * preconditioners that use them, and the two-level additive Schwarz
+ * preconditioner whose local solves run one subdomain per thread.
+ * @see precond.h
+ * @author Li Zhijun
+ * @date 2025-12-10
+ */
+#include <stdlib.h>
+#include <math.h>
+#include "precond.h"
+
+LevelSchedule* createLevelSchedule(const SplitCSR *split, int upper) {
+    const SparseCSR *matrix = split->matrix;
+    int n = matrix->rows;
+    int *level = (int *)malloc(n * sizeof(int));
+    int n_levels = 0;
+
+    for (int k = 0; k < n; k++) {
+        int i = upper ? n - 1 - k : k;
+        int start = upper ? split->upper_ptr[i] : matrix->row_ptr[i];
+        int end = upper ? matrix->row_ptr[i + 1] : (split->diag_ind[i] >= 0 ? split->diag_ind[i] : split->upper_ptr[i]);
+        int lev = 0;
+        for (int j = start; j < end; j++) {
+            int dep = level[matrix->col_ind[j]] + 1;
+            if (dep > lev) lev = dep;
+        }
+        level[i] = lev;
+        if (lev + 1 > n_levels) n_levels = lev + 1;
+    }
+
+    LevelSchedule *schedule = (LevelSchedule *)malloc(sizeof(LevelSchedule));
+    schedule->n_levels = n_levels;
+    schedule->level_ptr = (int *)calloc(n_levels + 1, sizeof(int));
+    schedule->level_rows = (int *)malloc(n * sizeof(int));
+
+    // Counting sort of the rows by level, keeping the row order within a level
+    for (int i = 0; i < n; i++) {
+        schedule->level_ptr[level[i] + 1]++;
+    }
+    for (int l = 0; l < n_levels; l++) {
+        schedule->level_ptr[l + 1] += schedule->level_ptr[l];
+    }
+    int *next = (int *)malloc(n_levels * sizeof(int));
+    for (int l = 0; l < n_levels; l++) {
+        next[l] = schedule->level_ptr[l];
+    }
+    for (int k = 0; k < n; k++) {
+        int i = upper ? n - 1 - k : k;
+        schedule->level_rows[next[level[i]]++] = i;
+    }
+
+    free(next);
+    free(level);
+    return schedule;
+}
+
+void freeLevelSchedule(LevelSchedule *schedule) {
+    if (schedule) {
+        free(schedule->level_ptr);
+        free(schedule->level_rows);
+        free(schedule);
+    }
+}
+
+/* Levels with fewer rows are not worth a barrier: consecutive narrow levels are solved by one thread. */
+#define PRECOND_LEVEL_MIN_ROWS 512
+
+/* Row i of the level-scheduled solve, all its dependencies being solved already. */
+static inline void level_solve_row(const SplitCSR *split, int i, int upper, int unit_diag, double omega, const double *b, double *x) {
+    const SparseCSR *matrix = split->matrix;
+    int start = upper ? split->upper_ptr[i] : matrix->row_ptr[i];
+    int end = upper ? matrix->row_ptr[i + 1] : split->diag_ind[i];
+    double sum = 0.0;
+    for (int j = start; j < end; j++) {
+        sum += matrix->values[j] * x[matrix->col_ind[j]];
+    }
+    double diag = unit_diag ? 1.0 : matrix->values[split->diag_ind[i]];
+    x[i] = (b[i] - omega * sum) / diag;
+}
+
+/*
+ * Solve (D + omega*L)x = b (upper == 0) or (D + omega*U)x = b (upper == 1) level by level.
+ * With unit_diag the diagonal is taken as 1. Small matrices are solved serially; in the
+ * parallel solve wide levels are split over the threads, and every run of narrow levels
+ * is solved by a single thread in level order, with one barrier for the whole run.
+ */
+static void level_triangular_solve(const SplitCSR *split, const LevelSchedule *schedule, int upper, int unit_diag, double omega, const double *b, double *x) {
+    const int *level_ptr = schedule->level_ptr;
+    const int *level_rows = schedule->level_rows;
+    int n_levels = schedule->n_levels;
+
+    #pragma omp parallel if (split->matrix->nnz >= CSR_PARALLEL_MIN_NNZ)
+    {
+        int l = 0;
+        while (l < n_levels) {
+            if (level_ptr[l + 1] - level_ptr[l] >= PRECOND_LEVEL_MIN_ROWS) {
+                #pragma omp for schedule(static)
+                for (int k = level_ptr[l]; k < level_ptr[l + 1]; k++) {
+                    level_solve_row(split, level_rows[k], upper, unit_diag, omega, b, x);
+                }
+                l++;
+            } else {
+                int first = l;
+                while (l < n_levels && level_ptr[l + 1] - level_ptr[l] < PRECOND_LEVEL_MIN_ROWS) {
+                    l++;
+                }
+                #pragma omp single
+                for (int k = level_ptr[first]; k < level_ptr[l]; k++) {
+                    level_solve_row(split, level_rows[k], upper, unit_diag, omega, b, x);
+                }
+            }
+        }
+    }
+}
+
+void lower_solve_levels_csr(const SplitCSR *split, const LevelSchedule *schedule, const double *b, double *x) {
+    level_triangular_solve(split, schedule, 0, 0, 1.0, b, x);
+}
+
+void upper_solve_levels_csr(const SplitCSR *split, const LevelSchedule *schedule, const double *b, double *x) {
+    level_triangular_solve(split, schedule, 1, 0, 1.0, b, x);
+}
+
+ILU0* createILU0(const SparseCSR *matrix) {
+    int n = matrix->rows;
+    SparseCSR *LU = createSparseCSR(n, matrix->cols, matrix->nnz);
+    for (int i = 0; i <= n; i++) {
+        LU->row_ptr[i] = matrix->row_ptr[i];
+    }
+    for (int j = 0; j < matrix->nnz; j++) {
+        LU->col_ind[j] = matrix->col_ind[j];
+        LU->values[j] = matrix->values[j];
+    }
+
+    ILU0 *ilu = (ILU0 *)malloc(sizeof(ILU0));
+    ilu->LU = LU;
+    ilu->split = createSplitCSR(LU);
+    const SplitCSR *split = ilu->split;
+
+    // IKJ variant restricted to the pattern of A; pos[c] is the index of column c in row i
+    int *pos = (int *)malloc(matrix->cols * sizeof(int));
+    for (int c = 0; c < matrix->cols; c++) {
+        pos[c] = -1;
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = LU->row_ptr[i]; j < LU->row_ptr[i + 1]; j++) {
+            pos[LU->col_ind[j]] = j;
+        }
+        for (int j = LU->row_ptr[i]; j < split->diag_ind[i]; j++) {
+            int k = LU->col_ind[j];
+            LU->values[j] /= LU->values[split->diag_ind[k]];
+            double lik = LU->values[j];
+            for (int m = split->upper_ptr[k]; m < LU->row_ptr[k + 1]; m++) {
+                int target = pos[LU->col_ind[m]];
+                if (target >= 0) {
+                    LU->values[target] -= lik * LU->values[m];
+                }
+            }
+        }
+        for (int j = LU->row_ptr[i]; j < LU->row_ptr[i + 1]; j++) {
+            pos[LU->col_ind[j]] = -1;
+        }
+    }
+    free(pos);
+
+    ilu->lower = createLevelSchedule(split, 0);
+    ilu->upper = createLevelSchedule(split, 1);
+    ilu->work = (double *)malloc(n * sizeof(double));
+    return ilu;
+}
+
+void freeILU0(ILU0 *ilu) {
+    if (ilu) {
+        freeLevelSchedule(ilu->lower);
+        freeLevelSchedule(ilu->upper);
+        freeSplitCSR(ilu->split);
+        freeSparseCSR(ilu->LU);
+        free(ilu->work);
+        free(ilu);
+    }
+}
+
+void apply_ILU0(const void *ctx, const double *r, double *z) {
+    const ILU0 *ilu = (const ILU0 *)ctx;
+    level_triangular_solve(ilu->split, ilu->lower, 0, 1, 1.0, r, ilu->work);
+    level_triangular_solve(ilu->split, ilu->upper, 1, 0, 1.0, ilu->work, z);
+}
+
+SSORPrecond* createSSORPrecond(SparseCSR *matrix, double omega) {
+    SSORPrecond *ssor = (SSORPrecond *)malloc(sizeof(SSORPrecond));
+    ssor->split = createSplitCSR(matrix);
+    ssor->lower = createLevelSchedule(ssor->split, 0);
+    ssor->upper = createLevelSchedule(ssor->split, 1);
+    ssor->omega = omega;
+    ssor->work = (double *)malloc(matrix->rows * sizeof(double));
+    return ssor;
+}
+
+void freeSSORPrecond(SSORPrecond *ssor) {
+    if (ssor) {
+        freeLevelSchedule(ssor->lower);
+        freeLevelSchedule(ssor->upper);
+        freeSplitCSR(ssor->split);
+        free(ssor->work);
+        free(ssor);
+    }
+}
+
+void apply_SSOR(const void *ctx, const double *r, double *z) {
+    const SSORPrecond *ssor = (const SSORPrecond *)ctx;
+    const SparseCSR *matrix = ssor->split->matrix;
+    int n = matrix->rows;
+    double omega = ssor->omega;
+    double *y = ssor->work;
+
+    // (D + wL) y = w (2 - w) r, y <- D y, (D + wU) z = y
+    for (int i = 0; i < n; i++) {
+        z[i] = omega * (2.0 - omega) * r[i];
+    }
+    level_triangular_solve(ssor->split, ssor->lower, 0, 0, omega, z, y);
+    for (int i = 0; i < n; i++) {
+        y[i] *= matrix->values[ssor->split->diag_ind[i]];
+    }
+    level_triangular_solve(ssor->split, ssor->upper, 1, 0, omega, y, z);
+}
+
+/* Rows holding only their diagonal entry (Dirichlet rows) are left out of the coarse space. */
+static int schwarz_decoupled_row(const SparseCSR *matrix, int i) {
+    return matrix->row_ptr[i + 1] - matrix->row_ptr[i] == 1 && matrix->col_ind[matrix->row_ptr[i]] == i;
+}
+
+/* Extract A_s = R_s A R_s^T; map holds -1 on entry and is restored on exit. */
+static SparseCSR* schwarz_local_matrix(const SparseCSR *matrix, const int *rows, int n_rows, int *map) {
+    int nnz = 0;
+    for (int k = 0; k < n_rows; k++) {
+        map[rows[k]] = k;
+        nnz += matrix->row_ptr[rows[k] + 1] - matrix->row_ptr[rows[k]];
+    }
+    SparseCSR *local = createSparseCSR(n_rows, n_rows, nnz);
+    int idx = 0;
+    local->row_ptr[0] = 0;
+    for (int k = 0; k < n_rows; k++) {
+        int i = rows[k];
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            int c = map[matrix->col_ind[j]];
+            if (c >= 0) {
+                local->col_ind[idx] = c;
+                local->values[idx] = matrix->values[j];
+                idx++;
+            }
+        }
+        local->row_ptr[k + 1] = idx;
+    }
+    local->nnz = idx;
+    for (int k = 0; k < n_rows; k++) {
+        map[rows[k]] = -1;
+    }
+    return local;
+}
+
+/*
+ * Coarse basis: phi_s solves A_s phi_s = 1 (0 on the decoupled rows) and is cut to the rows
+ * owned by s. Unlike plain indicators these shapes vanish towards Dirichlet boundaries,
+ * which every strip of the grid partitions touches.
+ */
+static void schwarz_coarse_basis(SchwarzPrecond *schwarz, double *phi) {
+    const SparseCSR *matrix = schwarz->matrix;
+    for (int k = 0; k < schwarz->sub_ptr[schwarz->n_sub]; k++) {
+        schwarz->local_r[k] = schwarz_decoupled_row(matrix, schwarz->sub_ind[k]) ? 0.0 : 1.0;
+    }
+    #pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < schwarz->n_sub; s++) {
+        solveBandLU(schwarz->local[s], schwarz->local_r + schwarz->sub_ptr[s], schwarz->local_z + schwarz->sub_ptr[s]);
+    }
+    for (int i = 0; i < matrix->rows; i++) {
+        phi[i] = schwarz_decoupled_row(matrix, i) ? 0.0 : schwarz->local_z[schwarz->owner_pos[i]];
+    }
+}
+
+/* Coarse matrix A_0 = Phi^T A Phi, Cholesky-factored in place. */
+static double* schwarz_coarse_matrix(const SparseCSR *matrix, const int *owner, const double *phi, int n_sub) {
+    double *A0 = (double *)calloc((size_t)n_sub * n_sub, sizeof(double));
+    for (int i = 0; i < matrix->rows; i++) {
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            int c = matrix->col_ind[j];
+            A0[(size_t)owner[i] * n_sub + owner[c]] += phi[i] * matrix->values[j] * phi[c];
+        }
+    }
+    for (int s = 0; s < n_sub; s++) {
+        if (A0[(size_t)s * n_sub + s] == 0.0) A0[(size_t)s * n_sub + s] = 1.0; // empty subdomain
+    }
+    for (int j = 0; j < n_sub; j++) {
+        double *aj = A0 + (size_t)j * n_sub;
+        for (int k = 0; k < j; k++) {
+            aj[j] -= aj[k] * aj[k];
+        }
+        if (aj[j] <= 0.0) {
+            free(A0);
+            return NULL;
+        }
+        aj[j] = sqrt(aj[j]);
+        for (int i = j + 1; i < n_sub; i++) {
+            double *ai = A0 + (size_t)i * n_sub;
+            for (int k = 0; k < j; k++) {
+                ai[j] -= ai[k] * aj[k];
+            }
+            ai[j] /= aj[j];
+        }
+    }
+    return A0;
+}
+
+SchwarzPrecond* createSchwarzPrecond(const SparseCSR *matrix, int n_sub, const int *sub_ptr, const int *sub_ind, const int *owner, int restricted, int coarse) {
+    int n = matrix->rows;
+    int total = sub_ptr[n_sub];
+    SchwarzPrecond *schwarz = (SchwarzPrecond *)malloc(sizeof(SchwarzPrecond));
+    schwarz->matrix = matrix;
+    schwarz->n_sub = n_sub;
+    schwarz->restricted = restricted;
+    schwarz->sub_ptr = (int *)malloc((n_sub + 1) * sizeof(int));
+    schwarz->sub_ind = (int *)malloc((total > 0 ? total : 1) * sizeof(int));
+    schwarz->owner = (int *)malloc(n * sizeof(int));
+    schwarz->owner_pos = (int *)malloc(n * sizeof(int));
+    schwarz->map_ptr = (int *)calloc(n + 1, sizeof(int));
+    schwarz->map_pos = (int *)malloc((total > 0 ? total : 1) * sizeof(int));
+    schwarz->local = (BandLU **)malloc(n_sub * sizeof(BandLU *));
+    schwarz->local_r = (double *)malloc((total > 0 ? total : 1) * sizeof(double));
+    schwarz->local_z = (double *)malloc((total > 0 ? total : 1) * sizeof(double));
+    schwarz->coarse_r = (double *)malloc(n_sub * sizeof(double));
+    schwarz->work = (double *)malloc(n * sizeof(double));
+    for (int s = 0; s <= n_sub; s++) {
+        schwarz->sub_ptr[s] = sub_ptr[s];
+    }
+    for (int i = 0; i < n; i++) {
+        schwarz->owner[i] = owner[i];
+    }
+
+    // Packed positions of every row: the copy in its owner, and all copies for the additive sum
+    for (int s = 0; s < n_sub; s++) {
+        for (int k = sub_ptr[s]; k < sub_ptr[s + 1]; k++) {
+            int i = sub_ind[k];
+            schwarz->sub_ind[k] = i;
+            schwarz->map_ptr[i + 1]++;
+            if (owner[i] == s) schwarz->owner_pos[i] = k;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        schwarz->map_ptr[i + 1] += schwarz->map_ptr[i];
+    }
+    int *next = (int *)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        next[i] = schwarz->map_ptr[i];
+    }
+    for (int k = 0; k < total; k++) {
+        schwarz->map_pos[next[sub_ind[k]]++] = k;
+    }
+    free(next);
+
+    // Extract and factor the local matrices, one subdomain per thread
+    int failed = 0;
+    #pragma omp parallel reduction(+:failed)
+    {
+        int *map = (int *)malloc(n * sizeof(int));
+        for (int i = 0; i < n; i++) {
+            map[i] = -1;
+        }
+        #pragma omp for schedule(dynamic)
+        for (int s = 0; s < n_sub; s++) {
+            int n_rows = sub_ptr[s + 1] - sub_ptr[s];
+            SparseCSR *local = schwarz_local_matrix(matrix, sub_ind + sub_ptr[s], n_rows, map);
+            int *perm = (int *)malloc((n_rows > 0 ? n_rows : 1) * sizeof(int));
+            rcm_order_csr(local, perm);
+            schwarz->local[s] = createBandLU(local, perm);
+            if (!schwarz->local[s]) failed++;
+            free(perm);
+            freeSparseCSR(local);
+        }
+        free(map);
+    }
+
+    schwarz->phi = NULL;
+    schwarz->coarse = NULL;
+    if (!failed && coarse) {
+        schwarz->phi = (double *)malloc(n * sizeof(double));
+        schwarz_coarse_basis(schwarz, schwarz->phi);
+        schwarz->coarse = schwarz_coarse_matrix(matrix, owner, schwarz->phi, n_sub);
+    }
+    if (failed || (coarse && !schwarz->coarse)) {
+        freeSchwarzPrecond(schwarz);
+        return NULL;
+    }
+    return schwarz;
+}
+
+void freeSchwarzPrecond(SchwarzPrecond *schwarz) {
+    if (schwarz) {
+        for (int s = 0; s < schwarz->n_sub; s++) {
+            freeBandLU(schwarz->local[s]);
+        }
+        free(schwarz->local);
+        free(schwarz->sub_ptr);
+        free(schwarz->sub_ind);
+        free(schwarz->owner);
+        free(schwarz->owner_pos);
+        free(schwarz->map_ptr);
+        free(schwarz->map_pos);
+        free(schwarz->local_r);
+        free(schwarz->local_z);
+        free(schwarz->coarse);
+        free(schwarz->coarse_r);
+        free(schwarz->phi);
+        free(schwarz->work);
+        free(schwarz);
+    }
+}
+
+/* z = Phi A_0^{-1} Phi^T r */
+static void schwarz_coarse_correction(const SchwarzPrecond *schwarz, const double *r, double *z) {
+    int n = schwarz->matrix->rows, n_sub = schwarz->n_sub;
+    double *y = schwarz->coarse_r;
+    const double *L = schwarz->coarse;
+    for (int s = 0; s < n_sub; s++) {
+        y[s] = 0.0;
+    }
+    for (int i = 0; i < n; i++) {
+        y[schwarz->owner[i]] += schwarz->phi[i] * r[i];
+    }
+    for (int s = 0; s < n_sub; s++) {
+        for (int k = 0; k < s; k++) {
+            y[s] -= L[(size_t)s * n_sub + k] * y[k];
+        }
+        y[s] /= L[(size_t)s * n_sub + s];
+    }
+    for (int s = n_sub - 1; s >= 0; s--) {
+        for (int k = s + 1; k < n_sub; k++) {
+            y[s] -= L[(size_t)k * n_sub + s] * y[k];
+        }
+        y[s] /= L[(size_t)s * n_sub + s];
+    }
+    for (int i = 0; i < n; i++) {
+        z[i] = schwarz->phi[i] * y[schwarz->owner[i]];
+    }
+}
+
+void apply_Schwarz(const void *ctx, const double *r, double *z) {
+    const SchwarzPrecond *schwarz = (const SchwarzPrecond *)ctx;
+    const SparseCSR *matrix = schwarz->matrix;
+    int n = matrix->rows, n_sub = schwarz->n_sub;
+    double *local_r = schwarz->local_r, *local_z = schwarz->local_z;
+
+    // Coarse correction: added to the local ones (additive), or applied first and the
+    // local solves taken on the updated residual r - A z0 (restricted)
+    const double *rhs = r;
+    if (schwarz->coarse) {
+        schwarz_coarse_correction(schwarz, r, z);
+        if (schwarz->restricted) {
+            spmv_csr(matrix, z, schwarz->work);
+            vec_waxpby(schwarz->work, 1.0, r, -1.0, schwarz->work, n);
+            rhs = schwarz->work;
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            z[i] = 0.0;
+        }
+    }
+
+    // Independent local solves, one subdomain per thread
+    #pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < n_sub; s++) {
+        for (int k = schwarz->sub_ptr[s]; k < schwarz->sub_ptr[s + 1]; k++) {
+            local_r[k] = rhs[schwarz->sub_ind[k]];
+        }
+        solveBandLU(schwarz->local[s], local_r + schwarz->sub_ptr[s], local_z + schwarz->sub_ptr[s]);
+    }
+
+    if (schwarz->restricted) {
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; i++) {
+            z[i] += local_z[schwarz->owner_pos[i]];
+        }
+    } else {
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; i++) {
+            double sum = 0.0;
+            for (int k = schwarz->map_ptr[i]; k < schwarz->map_ptr[i + 1]; k++) {
+                sum += local_z[schwarz->map_pos[k]];
+            }
+            z[i] += sum;
+        }
+    }
+}
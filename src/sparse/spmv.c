@@ -0,0 +1,555 @@
+/**
+ * @file spmv.c
+ * @brief Implementation of the SpMV autotuner.
+ *
+ * This file includes the candidate SpMV kernels (CSR, SELL-C-sigma, diagonal and
+ * value-indexed storage, serial and OpenMP), the conversions into their formats,
+ * and the inspector that times them on the matrix and keeps the fastest in a plan.
+ * Every kernel can also finish its rows with the update of a fused product.
+ * @see spmv.h
+ * @author Li Zhijun
+ * @date 2025-12-16
+ */
+#include <stdlib.h>
+#include <time.h>
+#include "spmv.h"
+#include "csrv.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Matrices with fewer nonzeros are not worth timing. */
+#define SPMV_TUNE_MIN_NNZ 4096
+
+/* Multiply-adds per timing run; small matrices repeat the product to reach it. */
+#define SPMV_TUNE_WORK (1 << 22)
+
+/* Timing runs per candidate; the fastest counts. */
+#define SPMV_TUNE_TRIALS 3
+
+/* Rows per SELL chunk (SIMD width across rows) and sorting window. */
+#define SPMV_SELL_CHUNK 8
+#define SPMV_SELL_SIGMA 256
+
+/* SELL is only tried while the padding stays below this fraction of the nonzeros. */
+#define SPMV_SELL_MAX_PADDING 0.5
+
+/* Diagonal storage is only tried for at most this many diagonals filled to at least half. */
+#define SPMV_DIA_MAX_DIAGONALS 32
+
+/* Rows the diagonal kernel accumulates in a local buffer before writing them. */
+#define SPMV_DIA_TILE 256
+
+typedef enum {
+    SPMV_CSR,
+    SPMV_CSR_UNROLLED,
+    SPMV_CSR_THREADS,
+    SPMV_SELL,
+    SPMV_SELL_THREADS,
+    SPMV_DIA,
+    SPMV_DIA_THREADS,
+    SPMV_CSRV,
+    SPMV_CSRV_THREADS,
+    SPMV_N_KERNELS
+} spmv_kernel;
+
+static const char *spmv_kernel_names[SPMV_N_KERNELS] = {
+    "csr", "csr-unrolled", "csr-threads", "sell", "sell-threads", "dia", "dia-threads",
+    "csr-indexed", "csr-indexed-threads"
+};
+
+struct SpMVPlan {
+    const SparseCSR *matrix;    /* Tuned matrix (not owned). */
+    spmv_kernel kernel;         /* Selected kernel. */
+
+    int n_parts;                /* Row blocks of the threaded CSR kernel, balanced by nonzeros. */
+    int *part_ptr;              /* First row of every block, size n_parts + 1. */
+
+    int n_chunks;               /* SELL: number of chunks of SPMV_SELL_CHUNK rows. */
+    int *chunk_ptr;             /* SELL: start of every chunk in sell_col/sell_val. */
+    int *chunk_len;             /* SELL: entries per row of every chunk. */
+    int *sell_row;              /* SELL: original row of every chunk slot (-1 for padding rows). */
+    int *sell_col;              /* SELL: column indices, column-major within a chunk. */
+    double *sell_val;           /* SELL: values, padded with zeros. */
+
+    int n_diags;                /* DIA: number of stored diagonals. */
+    int *dia_offset;            /* DIA: column offset of every diagonal. */
+    double *dia_val;            /* DIA: dia_val[d * rows + i] = A(i, i + offset[d]). */
+
+    SparseCSRv *csrv;           /* Value-indexed copy for matrices with few distinct values. */
+};
+
+/* Update of every row sum in a fused product y = alpha * A * x + beta * y + b + term. */
+typedef struct {
+    double alpha;
+    double beta;
+    const double *b;
+    csr_row_term term;
+    const void *ctx;
+} spmv_update;
+
+/* Result of row i from its sum, in the operation order of spmv_axpby_csr(); the plain sum without update. */
+static inline double spmv_row_result(const spmv_update *update, int i, double sum, const double *y) {
+    if (!update) return sum;
+    double result = update->alpha * sum;
+    if (update->beta != 0.0) result += update->beta * y[i];
+    if (update->b) result += update->b[i];
+    if (update->term) result += update->term(i, update->ctx);
+    return result;
+}
+
+static double spmv_wtime(void) {
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static int spmv_max_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/* Rows [row0, row1) of the reference row loop of spmv_csr(). */
+static void spmv_csr_rows(const SparseCSR *matrix, int row0, int row1, const double *x, double *y, const spmv_update *update) {
+    for (int i = row0; i < row1; i++) {
+        double sum = 0.0;
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            sum += matrix->values[j] * x[matrix->col_ind[j]];
+        }
+        y[i] = spmv_row_result(update, i, sum, y);
+    }
+}
+
+/* Rows [row0, row1) with the sum kept in a register, four entries per step. */
+static void spmv_csr_rows_unrolled(const SparseCSR *matrix, int row0, int row1, const double *x, double *y, const spmv_update *update) {
+    const int *row_ptr = matrix->row_ptr, *col_ind = matrix->col_ind;
+    const double *values = matrix->values;
+    for (int i = row0; i < row1; i++) {
+        double sum = 0.0;
+        int j = row_ptr[i], end = row_ptr[i + 1];
+        for (; j + 4 <= end; j += 4) {
+            sum += values[j] * x[col_ind[j]];
+            sum += values[j + 1] * x[col_ind[j + 1]];
+            sum += values[j + 2] * x[col_ind[j + 2]];
+            sum += values[j + 3] * x[col_ind[j + 3]];
+        }
+        for (; j < end; j++) {
+            sum += values[j] * x[col_ind[j]];
+        }
+        y[i] = spmv_row_result(update, i, sum, y);
+    }
+}
+
+static void spmv_sell_chunks(const SpMVPlan *plan, int chunk0, int chunk1, const double *x, double *y, const spmv_update *update) {
+    for (int k = chunk0; k < chunk1; k++) {
+        double acc[SPMV_SELL_CHUNK] = {0.0};
+        const int *col = plan->sell_col + plan->chunk_ptr[k];
+        const double *val = plan->sell_val + plan->chunk_ptr[k];
+        for (int j = 0; j < plan->chunk_len[k]; j++) {
+            for (int r = 0; r < SPMV_SELL_CHUNK; r++) {
+                acc[r] += val[j * SPMV_SELL_CHUNK + r] * x[col[j * SPMV_SELL_CHUNK + r]];
+            }
+        }
+        const int *rows = plan->sell_row + k * SPMV_SELL_CHUNK;
+        for (int r = 0; r < SPMV_SELL_CHUNK; r++) {
+            if (rows[r] >= 0) y[rows[r]] = spmv_row_result(update, rows[r], acc[r], y);
+        }
+    }
+}
+
+/* Rows [row0, row1) of the value-indexed copy, the sum kept in a register. */
+static void spmv_csrv_rows(const SparseCSRv *matrix, int row0, int row1, const double *x, double *y, const spmv_update *update) {
+    const int *row_ptr = matrix->row_ptr, *col_ind = matrix->col_ind;
+    const unsigned char *value_ind = matrix->value_ind;
+    const double *table = matrix->table;
+    for (int i = row0; i < row1; i++) {
+        double sum = 0.0;
+        for (int j = row_ptr[i]; j < row_ptr[i + 1]; j++) {
+            sum += table[value_ind[j]] * x[col_ind[j]];
+        }
+        y[i] = spmv_row_result(update, i, sum, y);
+    }
+}
+
+/* Rows [row0, row1) diagonal by diagonal, SPMV_DIA_TILE rows at a time accumulated in a local buffer. */
+static void spmv_dia_rows(const SpMVPlan *plan, int row0, int row1, const double *x, double *y, const spmv_update *update) {
+    int n = plan->matrix->rows, cols = plan->matrix->cols;
+    double acc[SPMV_DIA_TILE];
+    for (int tile = row0; tile < row1; tile += SPMV_DIA_TILE) {
+        int end = (tile + SPMV_DIA_TILE < row1) ? tile + SPMV_DIA_TILE : row1;
+        for (int i = tile; i < end; i++) {
+            acc[i - tile] = 0.0;
+        }
+        for (int d = 0; d < plan->n_diags; d++) {
+            int offset = plan->dia_offset[d];
+            int lo = (-offset > tile) ? -offset : tile;
+            int hi = (cols - offset < end) ? cols - offset : end;
+            const double *val = plan->dia_val + (size_t)d * n;
+            for (int i = lo; i < hi; i++) {
+                acc[i - tile] += val[i] * x[i + offset];
+            }
+        }
+        for (int i = tile; i < end; i++) {
+            y[i] = spmv_row_result(update, i, acc[i - tile], y);
+        }
+    }
+}
+
+/* Block p of n_blocks equal blocks of rows (of chunks for SELL) with the serial kernel of the plan. */
+static void spmv_plan_block(const SpMVPlan *plan, int p, int n_blocks, const double *x, double *y, const spmv_update *update) {
+    long rows = plan->matrix->rows, chunks = plan->n_chunks;
+    int row0 = (int)(rows * p / n_blocks), row1 = (int)(rows * (p + 1) / n_blocks);
+    switch (plan->kernel) {
+        case SPMV_CSR_UNROLLED:
+            spmv_csr_rows_unrolled(plan->matrix, row0, row1, x, y, update);
+            break;
+        case SPMV_SELL:
+            spmv_sell_chunks(plan, (int)(chunks * p / n_blocks), (int)(chunks * (p + 1) / n_blocks), x, y, update);
+            break;
+        case SPMV_DIA:
+            spmv_dia_rows(plan, row0, row1, x, y, update);
+            break;
+        case SPMV_CSRV:
+            spmv_csrv_rows(plan->csrv, row0, row1, x, y, update);
+            break;
+        default:
+            spmv_csr_rows(plan->matrix, row0, row1, x, y, update);
+            break;
+    }
+}
+
+static void spmv_plan_run(const SpMVPlan *plan, const double *x, double *y, const spmv_update *update) {
+    const SparseCSR *matrix = plan->matrix;
+    int threaded = plan->kernel == SPMV_CSR_THREADS || plan->kernel == SPMV_SELL_THREADS
+                || plan->kernel == SPMV_DIA_THREADS || plan->kernel == SPMV_CSRV_THREADS;
+    // The plan was timed on the bare product: row terms may cost more than the product itself
+    if (!threaded && update && update->term && matrix->rows >= CSR_TERM_PARALLEL_MIN_ROWS) {
+        #pragma omp parallel
+        {
+            int n_threads = 1, tid = 0;
+#ifdef _OPENMP
+            n_threads = omp_get_num_threads();
+            tid = omp_get_thread_num();
+#endif
+            spmv_plan_block(plan, tid, n_threads, x, y, update);
+        }
+        return;
+    }
+    switch (plan->kernel) {
+        case SPMV_CSR_THREADS:
+            #pragma omp parallel for schedule(static, 1)
+            for (int p = 0; p < plan->n_parts; p++) {
+                spmv_csr_rows_unrolled(matrix, plan->part_ptr[p], plan->part_ptr[p + 1], x, y, update);
+            }
+            break;
+        case SPMV_SELL_THREADS:
+            #pragma omp parallel for schedule(static, 16)
+            for (int k = 0; k < plan->n_chunks; k++) {
+                spmv_sell_chunks(plan, k, k + 1, x, y, update);
+            }
+            break;
+        case SPMV_DIA_THREADS:
+            #pragma omp parallel
+            {
+                int n_threads = 1, tid = 0;
+#ifdef _OPENMP
+                n_threads = omp_get_num_threads();
+                tid = omp_get_thread_num();
+#endif
+                long rows = matrix->rows;
+                spmv_dia_rows(plan, (int)(rows * tid / n_threads), (int)(rows * (tid + 1) / n_threads), x, y, update);
+            }
+            break;
+        case SPMV_CSRV_THREADS:
+            #pragma omp parallel for schedule(static, 1)
+            for (int p = 0; p < plan->n_parts; p++) {
+                spmv_csrv_rows(plan->csrv, plan->part_ptr[p], plan->part_ptr[p + 1], x, y, update);
+            }
+            break;
+        default:
+            spmv_plan_block(plan, 0, 1, x, y, update);
+            break;
+    }
+}
+
+void apply_SpMVPlan(const SpMVPlan *plan, const double *x, double *y) {
+    spmv_plan_run(plan, x, y, NULL);
+}
+
+void apply_axpby_SpMVPlan(const SpMVPlan *plan, double alpha, const double *x, double beta, double *y, const double *b, csr_row_term term, const void *ctx) {
+    spmv_update update = {alpha, beta, b, term, ctx};
+    spmv_plan_run(plan, x, y, &update);
+}
+
+/* Row blocks holding about the same number of nonzeros, a few per thread. */
+static void spmv_build_parts(SpMVPlan *plan, int n_threads) {
+    const SparseCSR *matrix = plan->matrix;
+    int n_parts = 4 * n_threads;
+    if (n_parts > matrix->rows) n_parts = matrix->rows > 0 ? matrix->rows : 1;
+    plan->n_parts = n_parts;
+    plan->part_ptr = (int *)malloc((n_parts + 1) * sizeof(int));
+    plan->part_ptr[0] = 0;
+    int row = 0;
+    for (int p = 1; p < n_parts; p++) {
+        long target = (long)matrix->nnz * p / n_parts;
+        while (row < matrix->rows && matrix->row_ptr[row] < target) {
+            row++;
+        }
+        plan->part_ptr[p] = row;
+    }
+    plan->part_ptr[n_parts] = matrix->rows;
+}
+
+/* SELL-C-sigma conversion; returns 0 (and builds nothing) if the padding is too large. */
+static int spmv_build_sell(SpMVPlan *plan) {
+    const SparseCSR *matrix = plan->matrix;
+    int n = matrix->rows;
+    int n_chunks = (n + SPMV_SELL_CHUNK - 1) / SPMV_SELL_CHUNK;
+    int *order = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    // Sort rows by decreasing length within every window of sigma rows (stable insertion sort)
+    for (int w = 0; w < n; w += SPMV_SELL_SIGMA) {
+        int end = (w + SPMV_SELL_SIGMA < n) ? w + SPMV_SELL_SIGMA : n;
+        for (int a = w + 1; a < end; a++) {
+            int row = order[a], len = matrix->row_ptr[row + 1] - matrix->row_ptr[row];
+            int b = a - 1;
+            while (b >= w && matrix->row_ptr[order[b] + 1] - matrix->row_ptr[order[b]] < len) {
+                order[b + 1] = order[b];
+                b--;
+            }
+            order[b + 1] = row;
+        }
+    }
+
+    int *chunk_ptr = (int *)malloc((n_chunks + 1) * sizeof(int));
+    int *chunk_len = (int *)malloc((n_chunks > 0 ? n_chunks : 1) * sizeof(int));
+    chunk_ptr[0] = 0;
+    for (int k = 0; k < n_chunks; k++) {
+        int len = 0;
+        for (int r = 0; r < SPMV_SELL_CHUNK && k * SPMV_SELL_CHUNK + r < n; r++) {
+            int row = order[k * SPMV_SELL_CHUNK + r];
+            int row_len = matrix->row_ptr[row + 1] - matrix->row_ptr[row];
+            if (row_len > len) len = row_len;
+        }
+        chunk_len[k] = len;
+        chunk_ptr[k + 1] = chunk_ptr[k] + len * SPMV_SELL_CHUNK;
+    }
+    if (chunk_ptr[n_chunks] > (1.0 + SPMV_SELL_MAX_PADDING) * matrix->nnz) {
+        free(order);
+        free(chunk_ptr);
+        free(chunk_len);
+        return 0;
+    }
+
+    int total = chunk_ptr[n_chunks];
+    plan->n_chunks = n_chunks;
+    plan->chunk_ptr = chunk_ptr;
+    plan->chunk_len = chunk_len;
+    plan->sell_row = (int *)malloc((n_chunks * SPMV_SELL_CHUNK > 0 ? n_chunks * SPMV_SELL_CHUNK : 1) * sizeof(int));
+    plan->sell_col = (int *)malloc((total > 0 ? total : 1) * sizeof(int));
+    plan->sell_val = (double *)malloc((total > 0 ? total : 1) * sizeof(double));
+    for (int k = 0; k < n_chunks; k++) {
+        for (int r = 0; r < SPMV_SELL_CHUNK; r++) {
+            int slot = k * SPMV_SELL_CHUNK + r;
+            int row = slot < n ? order[slot] : -1;
+            plan->sell_row[slot] = row;
+            int start = row >= 0 ? matrix->row_ptr[row] : 0;
+            int len = row >= 0 ? matrix->row_ptr[row + 1] - start : 0;
+            for (int j = 0; j < chunk_len[k]; j++) {
+                int idx = chunk_ptr[k] + j * SPMV_SELL_CHUNK + r;
+                // Padding repeats the last column of the row, so it stays in cache
+                plan->sell_col[idx] = j < len ? matrix->col_ind[start + j] : (len > 0 ? matrix->col_ind[start + len - 1] : 0);
+                plan->sell_val[idx] = j < len ? matrix->values[start + j] : 0.0;
+            }
+        }
+    }
+    free(order);
+    return 1;
+}
+
+/*
+ * Diagonal storage; returns 0 (and builds nothing) unless few, well-filled diagonals hold
+ * all entries. The diagonals are stored by increasing offset, which is the CSR order of
+ * every row only if the columns are sorted, so unsorted matrices are not converted.
+ */
+static int spmv_build_dia(SpMVPlan *plan) {
+    const SparseCSR *matrix = plan->matrix;
+    int n = matrix->rows;
+    int offsets[SPMV_DIA_MAX_DIAGONALS];
+    int n_diags = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            if (j > matrix->row_ptr[i] && matrix->col_ind[j] <= matrix->col_ind[j - 1]) return 0;
+            int offset = matrix->col_ind[j] - i, d = 0;
+            while (d < n_diags && offsets[d] != offset) {
+                d++;
+            }
+            if (d == n_diags) {
+                if (n_diags == SPMV_DIA_MAX_DIAGONALS) return 0;
+                offsets[n_diags++] = offset;
+            }
+        }
+    }
+    if ((double)n_diags * n > 2.0 * matrix->nnz) return 0;
+    for (int d = 1; d < n_diags; d++) {
+        int offset = offsets[d], e = d - 1;
+        while (e >= 0 && offsets[e] > offset) {
+            offsets[e + 1] = offsets[e];
+            e--;
+        }
+        offsets[e + 1] = offset;
+    }
+
+    plan->n_diags = n_diags;
+    plan->dia_offset = (int *)malloc((n_diags > 0 ? n_diags : 1) * sizeof(int));
+    plan->dia_val = (double *)calloc((size_t)(n_diags > 0 ? n_diags : 1) * (n > 0 ? n : 1), sizeof(double));
+    for (int d = 0; d < n_diags; d++) {
+        plan->dia_offset[d] = offsets[d];
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            int offset = matrix->col_ind[j] - i, d = 0;
+            while (offsets[d] != offset) {
+                d++;
+            }
+            plan->dia_val[(size_t)d * n + i] += matrix->values[j];
+        }
+    }
+    return 1;
+}
+
+SpMVPlan* createSpMVPlan(const SparseCSR *matrix) {
+    SpMVPlan *plan = (SpMVPlan *)calloc(1, sizeof(SpMVPlan));
+    plan->matrix = matrix;
+    plan->kernel = SPMV_CSR;
+    if (matrix->nnz < SPMV_TUNE_MIN_NNZ) return plan;
+
+    int n_threads = spmv_max_threads();
+    int available[SPMV_N_KERNELS] = {0};
+    available[SPMV_CSR] = 1;
+    available[SPMV_CSR_UNROLLED] = 1;
+    if (n_threads > 1) {
+        spmv_build_parts(plan, n_threads);
+        available[SPMV_CSR_THREADS] = 1;
+    }
+    if (spmv_build_sell(plan)) {
+        available[SPMV_SELL] = 1;
+        available[SPMV_SELL_THREADS] = n_threads > 1;
+    }
+    if (spmv_build_dia(plan)) {
+        available[SPMV_DIA] = 1;
+        available[SPMV_DIA_THREADS] = n_threads > 1;
+    }
+    plan->csrv = createSparseCSRv(matrix);
+    if (plan->csrv) {
+        available[SPMV_CSRV] = 1;
+        available[SPMV_CSRV_THREADS] = n_threads > 1;
+    }
+
+    int n = matrix->rows;
+    double *x = (double *)malloc((matrix->cols > 0 ? matrix->cols : 1) * sizeof(double));
+    double *y = (double *)malloc((n > 0 ? n : 1) * sizeof(double));
+    double *y_ref = (double *)malloc((n > 0 ? n : 1) * sizeof(double));
+    for (int j = 0; j < matrix->cols; j++) {
+        x[j] = 1.0 + (j % 7) * 0.125;
+    }
+    spmv_csr_rows(matrix, 0, n, x, y_ref, NULL);
+
+    int reps = SPMV_TUNE_WORK / matrix->nnz;
+    if (reps < 1) reps = 1;
+    spmv_kernel best = SPMV_CSR;
+    double best_time = -1.0;
+    for (int k = 0; k < SPMV_N_KERNELS; k++) {
+        if (!available[k]) continue;
+        plan->kernel = (spmv_kernel)k;
+
+        // Every kernel sums each row in CSR order; reject one that does not reproduce the reference
+        apply_SpMVPlan(plan, x, y);
+        int same = 1;
+        for (int i = 0; i < n; i++) {
+            if (y[i] != y_ref[i]) same = 0;
+        }
+        if (!same) continue;
+
+        double time = -1.0;
+        for (int trial = 0; trial < SPMV_TUNE_TRIALS; trial++) {
+            double start = spmv_wtime();
+            for (int r = 0; r < reps; r++) {
+                apply_SpMVPlan(plan, x, y);
+            }
+            double elapsed = spmv_wtime() - start;
+            if (time < 0.0 || elapsed < time) time = elapsed;
+        }
+        if (best_time < 0.0 || time < best_time) {
+            best_time = time;
+            best = (spmv_kernel)k;
+        }
+    }
+
+    // Keep only the format of the winner
+    plan->kernel = best;
+    if (best != SPMV_CSR_THREADS && best != SPMV_CSRV_THREADS) {
+        free(plan->part_ptr);
+        plan->part_ptr = NULL;
+    }
+    if (best != SPMV_SELL && best != SPMV_SELL_THREADS) {
+        free(plan->chunk_ptr);
+        free(plan->chunk_len);
+        free(plan->sell_row);
+        free(plan->sell_col);
+        free(plan->sell_val);
+        plan->chunk_ptr = plan->chunk_len = plan->sell_row = plan->sell_col = NULL;
+        plan->sell_val = NULL;
+    }
+    if (best != SPMV_DIA && best != SPMV_DIA_THREADS) {
+        free(plan->dia_offset);
+        free(plan->dia_val);
+        plan->dia_offset = NULL;
+        plan->dia_val = NULL;
+    }
+    if (best != SPMV_CSRV && best != SPMV_CSRV_THREADS) {
+        freeSparseCSRv(plan->csrv);
+        plan->csrv = NULL;
+    }
+
+    free(x);
+    free(y);
+    free(y_ref);
+    return plan;
+}
+
+const char* name_SpMVPlan(const SpMVPlan *plan) {
+    return spmv_kernel_names[plan->kernel];
+}
+
+void freeSpMVPlan(SpMVPlan *plan) {
+    if (plan) {
+        free(plan->part_ptr);
+        free(plan->chunk_ptr);
+        free(plan->chunk_len);
+        free(plan->sell_row);
+        free(plan->sell_col);
+        free(plan->sell_val);
+        free(plan->dia_offset);
+        free(plan->dia_val);
+        freeSparseCSRv(plan->csrv);
+        free(plan);
+    }
+}
+
+void tune_spmv_csr(SparseCSR *matrix) {
+    untune_spmv_csr(matrix);
+    matrix->plan = createSpMVPlan(matrix);
+}
+
+void untune_spmv_csr(SparseCSR *matrix) {
+    freeSpMVPlan(matrix->plan);
+    matrix->plan = NULL;
+}
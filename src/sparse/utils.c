@@ -63,6 +63,20 @@ void print_int_matrix(const int **matrix, int rows, int cols) {
     }
 }
 
+void print_byte_matrix(const unsigned char *matrix, int rows, int cols) {
+    for (int i = 0; i < rows; i++) {
+        if (i == 0) {printf("[");}
+        else {printf(" ");}
+        printf("[");
+        for (int j = 0; j < cols; j++) {
+            printf("%d ", matrix[(size_t)i * cols + j]);
+        }
+        printf("]");
+        if (i == rows - 1) {printf("]\n");}
+        else {printf(",\n");}
+    }
+}
+
 void print_SparseCSR(const SparseCSR *matrix, int ndec) {
     /*Only Suitable for Columns Sorted CSR Format*/
     for (int i = 0; i < matrix->rows; i++) {
@@ -133,3 +147,23 @@ void write_csv_int_matrix(const char *filename, int **matrix, int rows, int cols
 
     fclose(file);
 }
+
+void write_csv_byte_matrix(const char *filename, const unsigned char *matrix, int rows, int cols) {
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        perror("Error opening file for writing");
+        return;
+    }
+
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            fprintf(file, "%d", matrix[(size_t)i * cols + j]);
+            if (j < cols - 1) {
+                fprintf(file, ",");
+            }
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+}
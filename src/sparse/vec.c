@@ -3,40 +3,444 @@
  * @brief Implementation of basic vector operations.
  * 
  * This file contains the implementation of functions for basic vector operations such as
- * copying, addition, subtraction, scaling, and dot product.
+ * copying, addition, subtraction, scaling, axpy-style updates and elementwise products,
+ * the blocked reproducible (optionally compensated) reductions, norms and multi-dots.
+ * Every kernel has a scalar and an AVX2 version selected at run time, and runs on the
+ * OpenMP threads above a size threshold.
  * @see vec.h
  * @author Li Zhijun
  * @date 2025-10-10
  */
+#include <stdlib.h>
+#include <math.h>
 #include "vec.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+/* Elementwise operations below this many elements run on the calling thread. */
+#define VEC_PARALLEL_MIN 32768
+
+/* Independent accumulators per block; a power of two, so they combine as a tree. */
+#define VEC_REDUCE_LANES 8
+
+/* Blocks reduced by one pairwise tree; larger vectors chain the tree results in order. */
+#define VEC_REDUCE_FANIN 1024
+
+/* Below this many blocks the reduction runs on the calling thread. */
+#define VEC_REDUCE_PARALLEL_BLOCKS 16
+
+/* Veltkamp splitting constant 2^27 + 1: splits a double into two halves of 26 bits. */
+#define VEC_SPLIT_FACTOR 134217729.0
+
+#ifndef FP_FAST_FMA
+/* Exact rounding error of the product x = a * b without fma (Dekker's TwoProduct). */
+static inline double two_product_error(double a, double b, double x) {
+    double t = VEC_SPLIT_FACTOR * a;
+    double a_hi = t - (t - a), a_lo = a - a_hi;
+    t = VEC_SPLIT_FACTOR * b;
+    double b_hi = t - (t - b), b_lo = b - b_hi;
+    return ((a_hi * b_hi - x) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+}
+#endif
+
+/* Exact rounding error of the product x = a * b: one fma when it is as fast as a multiply. */
+#ifdef FP_FAST_FMA
+#define VEC_PRODUCT_ERROR(a, b, x) fma((a), (b), -(x))
+#else
+#define VEC_PRODUCT_ERROR(a, b, x) two_product_error((a), (b), (x))
+#endif
+
+/* Runtime dispatch between the scalar kernels and their AVX2 versions (GCC/Clang on x86). */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VEC_X86_DISPATCH
+#endif
+
+static int vec_avx2 = -1;
+
+static int vec_cpu_avx2(void) {
+    int avx2 = 0;
+#ifdef VEC_X86_DISPATCH
+    __builtin_cpu_init();
+    avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+    return avx2;
+}
+
+static int vec_use_avx2(void) {
+    if (vec_avx2 < 0) {
+        vec_avx2 = vec_cpu_avx2();
+    }
+    return vec_avx2;
+}
+
+void vec_simd_enable(int enable) {
+    vec_avx2 = enable ? vec_cpu_avx2() : 0;
+}
+
+const char* vec_simd_name(void) {
+    return vec_use_avx2() ? "avx2" : "scalar";
+}
+
+/*
+ * Elementwise kernels over [0, n). None of them contracts a multiply-add into an fma,
+ * so the AVX2 and scalar versions give bitwise the same results.
+ */
+typedef enum {
+    VEC_OP_WAXPBY,  /* w = alpha * x + beta * y (y not read if beta == 0) */
+    VEC_OP_MULT,    /* w = x .* y */
+    VEC_OP_DIVIDE   /* w = x ./ y */
+} vec_op;
+
+static void elementwise_scalar(vec_op op, double *w, double alpha, const double *x, double beta, const double *y, int n) {
+    switch (op) {
+        case VEC_OP_WAXPBY:
+            if (beta == 0.0) {
+                for (int i = 0; i < n; i++) {
+                    w[i] = alpha * x[i];
+                }
+            } else {
+                for (int i = 0; i < n; i++) {
+                    w[i] = alpha * x[i] + beta * y[i];
+                }
+            }
+            break;
+        case VEC_OP_MULT:
+            for (int i = 0; i < n; i++) {
+                w[i] = x[i] * y[i];
+            }
+            break;
+        case VEC_OP_DIVIDE:
+            for (int i = 0; i < n; i++) {
+                w[i] = x[i] / y[i];
+            }
+            break;
+    }
+}
+
+#ifdef VEC_X86_DISPATCH
+__attribute__((target("avx2")))
+static void elementwise_avx2(vec_op op, double *w, double alpha, const double *x, double beta, const double *y, int n) {
+    __m256d va = _mm256_set1_pd(alpha), vb = _mm256_set1_pd(beta);
+    int i = 0;
+    switch (op) {
+        case VEC_OP_WAXPBY:
+            if (beta == 0.0) {
+                for (; i + 4 <= n; i += 4) {
+                    _mm256_storeu_pd(w + i, _mm256_mul_pd(va, _mm256_loadu_pd(x + i)));
+                }
+            } else {
+                for (; i + 4 <= n; i += 4) {
+                    __m256d ax = _mm256_mul_pd(va, _mm256_loadu_pd(x + i));
+                    __m256d by = _mm256_mul_pd(vb, _mm256_loadu_pd(y + i));
+                    _mm256_storeu_pd(w + i, _mm256_add_pd(ax, by));
+                }
+            }
+            break;
+        case VEC_OP_MULT:
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(w + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+            }
+            break;
+        case VEC_OP_DIVIDE:
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(w + i, _mm256_div_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+            }
+            break;
+    }
+    elementwise_scalar(op, w + i, alpha, x + i, beta, y ? y + i : NULL, n - i);
+}
+#endif
+
+/* Split [0, n) into one contiguous range per thread above VEC_PARALLEL_MIN elements. */
+static void elementwise(vec_op op, double *w, double alpha, const double *x, double beta, const double *y, int n) {
+    int avx2 = vec_use_avx2();
+    #pragma omp parallel if (n >= VEC_PARALLEL_MIN)
+    {
+        int n_threads = 1, tid = 0;
+#ifdef _OPENMP
+        n_threads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+#endif
+        // Range boundaries on multiples of 8 doubles (a cache line)
+        int start = (int)((long)(n / 8) * tid / n_threads) * 8;
+        int end = (tid == n_threads - 1) ? n : (int)((long)(n / 8) * (tid + 1) / n_threads) * 8;
+        const double *y_part = y ? y + start : NULL;
+#ifdef VEC_X86_DISPATCH
+        if (avx2) {
+            elementwise_avx2(op, w + start, alpha, x + start, beta, y_part, end - start);
+        } else
+#endif
+        {
+            (void)avx2;
+            elementwise_scalar(op, w + start, alpha, x + start, beta, y_part, end - start);
+        }
+    }
+}
 
 void vec_copy(double *dest, const double *src, int n) {
+    #pragma omp parallel for schedule(static) if (n >= VEC_PARALLEL_MIN)
     for (int i = 0; i < n; i++) {
         dest[i] = src[i];
     }
 }
 
 void vec_add(double *a, const double *b, int n) {
-    for (int i = 0; i < n; i++) {
-        a[i] += b[i];
-    }
+    elementwise(VEC_OP_WAXPBY, a, 1.0, a, 1.0, b, n);
 }
 
 void vec_sub(double *a, const double *b, int n) {
-    for (int i = 0; i < n; i++) {
-        a[i] -= b[i];
-    }
+    elementwise(VEC_OP_WAXPBY, a, 1.0, a, -1.0, b, n);
 }
 
 void vec_scale(double *a, double scalar, int n) {
-    for (int i = 0; i < n; i++) {
-        a[i] *= scalar;
+    elementwise(VEC_OP_WAXPBY, a, scalar, a, 0.0, NULL, n);
+}
+
+void vec_axpy(double *y, double alpha, const double *x, int n) {
+    elementwise(VEC_OP_WAXPBY, y, alpha, x, 1.0, y, n);
+}
+
+void vec_axpby(double *y, double alpha, const double *x, double beta, int n) {
+    elementwise(VEC_OP_WAXPBY, y, alpha, x, beta, y, n);
+}
+
+void vec_waxpby(double *w, double alpha, const double *x, double beta, const double *y, int n) {
+    elementwise(VEC_OP_WAXPBY, w, alpha, x, beta, y, n);
+}
+
+void vec_pointwise_mult(double *w, const double *x, const double *y, int n) {
+    elementwise(VEC_OP_MULT, w, 1.0, x, 1.0, y, n);
+}
+
+void vec_pointwise_divide(double *w, const double *x, const double *y, int n) {
+    elementwise(VEC_OP_DIVIDE, w, 1.0, x, 1.0, y, n);
+}
+
+/* Sum of a[i] (b == NULL) or a[i] * b[i] over one block, in a fixed lane order. */
+static double block_sum(const double *a, const double *b, int n) {
+    double acc[VEC_REDUCE_LANES] = {0.0};
+    int i = 0;
+    if (b) {
+        for (; i + VEC_REDUCE_LANES <= n; i += VEC_REDUCE_LANES) {
+            for (int l = 0; l < VEC_REDUCE_LANES; l++) {
+                acc[l] += a[i + l] * b[i + l];
+            }
+        }
+        for (int l = 0; i < n; i++, l++) {
+            acc[l] += a[i] * b[i];
+        }
+    } else {
+        for (; i + VEC_REDUCE_LANES <= n; i += VEC_REDUCE_LANES) {
+            for (int l = 0; l < VEC_REDUCE_LANES; l++) {
+                acc[l] += a[i + l];
+            }
+        }
+        for (int l = 0; i < n; i++, l++) {
+            acc[l] += a[i];
+        }
+    }
+    for (int width = VEC_REDUCE_LANES / 2; width >= 1; width /= 2) {
+        for (int l = 0; l < width; l++) {
+            acc[l] += acc[l + width];
+        }
+    }
+    return acc[0];
+}
+
+#ifdef VEC_X86_DISPATCH
+#if VEC_REDUCE_LANES != 8
+#error "block_sum_avx2 keeps the VEC_REDUCE_LANES lanes in two 4-wide registers"
+#endif
+/* block_sum() with lanes 0-3 and 4-7 in two registers: same lanes, same order, same result. */
+__attribute__((target("avx2")))
+static double block_sum_avx2(const double *a, const double *b, int n) {
+    __m256d acc_lo = _mm256_setzero_pd(), acc_hi = _mm256_setzero_pd();
+    int i = 0;
+    if (b) {
+        for (; i + VEC_REDUCE_LANES <= n; i += VEC_REDUCE_LANES) {
+            acc_lo = _mm256_add_pd(acc_lo, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            acc_hi = _mm256_add_pd(acc_hi, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+        }
+    } else {
+        for (; i + VEC_REDUCE_LANES <= n; i += VEC_REDUCE_LANES) {
+            acc_lo = _mm256_add_pd(acc_lo, _mm256_loadu_pd(a + i));
+            acc_hi = _mm256_add_pd(acc_hi, _mm256_loadu_pd(a + i + 4));
+        }
+    }
+    double acc[VEC_REDUCE_LANES];
+    _mm256_storeu_pd(acc, acc_lo);
+    _mm256_storeu_pd(acc + 4, acc_hi);
+    for (int l = 0; i < n; i++, l++) {
+        acc[l] += b ? a[i] * b[i] : a[i];
+    }
+    for (int width = VEC_REDUCE_LANES / 2; width >= 1; width /= 2) {
+        for (int l = 0; l < width; l++) {
+            acc[l] += acc[l + width];
+        }
+    }
+    return acc[0];
+}
+#endif
+
+static double block_sum_dispatch(const double *a, const double *b, int n, int avx2) {
+#ifdef VEC_X86_DISPATCH
+    if (avx2) return block_sum_avx2(a, b, n);
+#endif
+    (void)avx2;
+    return block_sum(a, b, n);
+}
+
+/* Error-free accumulation: s + c <- s + c + x + e, with the rounding error of s + x kept in c (TwoSum). */
+static inline void two_sum_accumulate(double *s, double *c, double x, double e) {
+    double t = *s + x;
+    double z = t - *s;
+    *c += ((*s - (t - z)) + (x - z)) + e;
+    *s = t;
+}
+
+/*
+ * Compensated block sum: every lane keeps its running sum s and the accumulated
+ * rounding errors c (TwoSum, plus TwoProduct for the products); returns s, stores c.
+ */
+static double block_sum_compensated(const double *a, const double *b, int n, double *err) {
+    double s[VEC_REDUCE_LANES] = {0.0}, c[VEC_REDUCE_LANES] = {0.0};
+    int i = 0;
+    if (b) {
+        for (; i + VEC_REDUCE_LANES <= n; i += VEC_REDUCE_LANES) {
+            for (int l = 0; l < VEC_REDUCE_LANES; l++) {
+                double x = a[i + l] * b[i + l];
+                two_sum_accumulate(&s[l], &c[l], x, VEC_PRODUCT_ERROR(a[i + l], b[i + l], x));
+            }
+        }
+        for (int l = 0; i < n; i++, l++) {
+            double x = a[i] * b[i];
+            two_sum_accumulate(&s[l], &c[l], x, VEC_PRODUCT_ERROR(a[i], b[i], x));
+        }
+    } else {
+        for (; i + VEC_REDUCE_LANES <= n; i += VEC_REDUCE_LANES) {
+            for (int l = 0; l < VEC_REDUCE_LANES; l++) {
+                two_sum_accumulate(&s[l], &c[l], a[i + l], 0.0);
+            }
+        }
+        for (int l = 0; i < n; i++, l++) {
+            two_sum_accumulate(&s[l], &c[l], a[i], 0.0);
+        }
+    }
+    for (int width = VEC_REDUCE_LANES / 2; width >= 1; width /= 2) {
+        for (int l = 0; l < width; l++) {
+            two_sum_accumulate(&s[l], &c[l], s[l + width], c[l + width]);
+        }
+    }
+    *err = c[0];
+    return s[0];
+}
+
+/*
+ * Reproducible reduction: blocks of VEC_REDUCE_BLOCK elements are summed independently
+ * (in parallel), then combined by a pairwise tree whose shape only depends on n.
+ */
+static double vec_reduce(const double *a, const double *b, int n, int compensated) {
+    double sum[VEC_REDUCE_FANIN], err[VEC_REDUCE_FANIN];
+    double total = 0.0, total_err = 0.0;
+    int chunk = VEC_REDUCE_BLOCK * VEC_REDUCE_FANIN;
+    int avx2 = vec_use_avx2();
+    for (int start = 0; start < n; start += chunk) {
+        int len = (n - start < chunk) ? n - start : chunk;
+        int n_blocks = (len + VEC_REDUCE_BLOCK - 1) / VEC_REDUCE_BLOCK;
+
+        #pragma omp parallel for schedule(static) if (n_blocks >= VEC_REDUCE_PARALLEL_BLOCKS)
+        for (int k = 0; k < n_blocks; k++) {
+            int offset = start + k * VEC_REDUCE_BLOCK;
+            int size = (n - offset < VEC_REDUCE_BLOCK) ? n - offset : VEC_REDUCE_BLOCK;
+            if (compensated) {
+                sum[k] = block_sum_compensated(a + offset, b ? b + offset : NULL, size, &err[k]);
+            } else {
+                sum[k] = block_sum_dispatch(a + offset, b ? b + offset : NULL, size, avx2);
+                err[k] = 0.0;
+            }
+        }
+
+        for (int width = 1; width < n_blocks; width *= 2) {
+            for (int k = 0; k + width < n_blocks; k += 2 * width) {
+                if (compensated) {
+                    two_sum_accumulate(&sum[k], &err[k], sum[k + width], err[k + width]);
+                } else {
+                    sum[k] += sum[k + width];
+                }
+            }
+        }
+
+        two_sum_accumulate(&total, &total_err, sum[0], err[0]);
     }
+    return compensated ? total + total_err : total;
 }
+
 double vec_dot(const double *a, const double *b, int n) {
-    double result = 0.0;
+    return vec_reduce(a, b, n, 0);
+}
+
+double vec_dot_compensated(const double *a, const double *b, int n) {
+    return vec_reduce(a, b, n, 1);
+}
+
+double vec_sum(const double *a, int n) {
+    return vec_reduce(a, NULL, n, 0);
+}
+
+double vec_sum_compensated(const double *a, int n) {
+    return vec_reduce(a, NULL, n, 1);
+}
+
+double vec_norm2(const double *a, int n) {
+    return sqrt(vec_reduce(a, a, n, 0));
+}
+
+double vec_norm_inf(const double *a, int n) {
+    double norm = 0.0;
+    #pragma omp parallel for schedule(static) reduction(max:norm) if (n >= VEC_PARALLEL_MIN)
     for (int i = 0; i < n; i++) {
-        result += a[i] * b[i];
+        double v = fabs(a[i]);
+        if (v > norm) norm = v;
+    }
+    return norm;
+}
+
+void vec_mdot(const double *a, const double *const *b, int m, int n, double *result) {
+    // Same blocks and tree as vec_reduce(), with the m block sums of a block computed
+    // while it is in cache, so every result equals vec_dot(a, b[q], n)
+    double *sum = (double *)malloc((size_t)(m > 0 ? m : 1) * VEC_REDUCE_FANIN * sizeof(double));
+    int chunk = VEC_REDUCE_BLOCK * VEC_REDUCE_FANIN;
+    int avx2 = vec_use_avx2();
+    for (int q = 0; q < m; q++) {
+        result[q] = 0.0;
     }
-    return result;
-}
\ No newline at end of file
+    for (int start = 0; start < n; start += chunk) {
+        int len = (n - start < chunk) ? n - start : chunk;
+        int n_blocks = (len + VEC_REDUCE_BLOCK - 1) / VEC_REDUCE_BLOCK;
+
+        #pragma omp parallel for schedule(static) if (n_blocks >= VEC_REDUCE_PARALLEL_BLOCKS)
+        for (int k = 0; k < n_blocks; k++) {
+            int offset = start + k * VEC_REDUCE_BLOCK;
+            int size = (n - offset < VEC_REDUCE_BLOCK) ? n - offset : VEC_REDUCE_BLOCK;
+            for (int q = 0; q < m; q++) {
+                sum[q * VEC_REDUCE_FANIN + k] = block_sum_dispatch(a + offset, b[q] + offset, size, avx2);
+            }
+        }
+
+        for (int q = 0; q < m; q++) {
+            double *s = sum + q * VEC_REDUCE_FANIN;
+            for (int width = 1; width < n_blocks; width *= 2) {
+                for (int k = 0; k + width < n_blocks; k += 2 * width) {
+                    s[k] += s[k + width];
+                }
+            }
+            result[q] += s[0];
+        }
+    }
+    free(sum);
+}
+
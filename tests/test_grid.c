@@ -0,0 +1,359 @@
+/**
+ * @file test_grid.c
+ * @brief Check the grid utilities: neighbour table, partitions, polygon classification, gathers and scatters.
+ *
+ * @details
+ * The neighbour table of the grid of the L-shaped domain of test_solvers.c must agree
+ * with the index map, including the -1 entries of exterior and off-grid neighbours.
+ * The grid is partitioned into strips,
+ * which must own every active point exactly once and contain their own points.
+ * The polygon of the Dirichlet example, classified by classify_Geometry2D(), must give
+ * the grid its hand-written region divider gave, and the same divider applied a line at a
+ * time must give the same grid. Grids above GRID_PARALLEL_MIN_POINTS, classified and
+ * indexed by several threads, must be numbered like the serial i-major sweep. Scattering an active vector to the grid
+ * and gathering it back must reproduce it bitwise.
+ * The program prints one line per check and returns the number of failed checks.
+ *
+ * Usage:
+ * Compile the program and run it.
+ *
+ * Example:
+ * \verbatim
+   mkdir build && cd build
+   cmake ..
+   make
+   ../bin/test_grid \endverbatim
+ * @see grid.h, test_utils.h
+ * @author Li Zhijun
+ * @date 2025-12-22
+ * @test test_grid.c
+ */
+# include <stdio.h>
+# include <stdlib.h>
+# include <math.h>
+# include "grid.h"
+# include "geometry.h"
+# include "test_utils.h"
+# ifdef _OPENMP
+# include <omp.h>
+# endif
+
+/** Grid points per direction of the test grid, and of one large enough to be built and copied in parallel. */
+# define TEST_N 33
+# define TEST_N_LARGE 301
+
+/** Threads of the parallel grid operations. */
+# define TEST_THREADS 4
+
+/**
+ * @brief Grid of n x n points of the L-shaped domain [0, 1]^2 without (0.5, 1] x (0.5, 1], one tag per edge.
+ */
+Grid2D* create_test_grid(int n) {
+    double x[] = {0.0, 1.0, 1.0, 0.5, 0.5, 0.0};
+    double y[] = {0.0, 0.0, 0.5, 0.5, 1.0, 1.0};
+    int tags[] = {2, 3, 4, 5, 6, 7};
+    Geometry2D *domain = create_Geometry2D();
+    add_polygon_Geometry2D(domain, 6, x, y, tags);
+    Grid2D *grid = initialize_Grid_geometry(n, n, 0.0, 1.0, 0.0, 1.0, domain);
+    free_Geometry2D(domain);
+    return grid;
+}
+
+/**
+ * @brief Whether two vectors are bitwise equal.
+ */
+int same_values(const double *a, const double *b, int n) {
+    for (int i = 0; i < n; i++) {
+        if (a[i] != b[i]) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Hand-written region divider of the Dirichlet example domain, before it was described by a polygon.
+ */
+int dirichlet_region_divider(double x, double y, double hx, double hy) {
+    double eps = 1e-12;
+    if (y > 1.0 && y <= (2.0 + eps)) {
+        if (x >= (y - 1.0 - eps) && x <= (3.0 - y + eps)) {
+            if (x <= y - 1.0 + hx - 2 * eps) {
+                return 2; // Top left slant boundary
+            } else if (x >= 3.0 - y - hx + 2 * eps) {
+                return 3; // Top right slant boundary
+            } else {
+                return 1; // Active interior point
+            }
+        } else {
+            return 0;
+        }
+    }
+    else if (y > -1.0 && y <= 1.0) {
+        if (x >= -eps && x <= (0.5 * y + 1.5 + eps)) {
+            if (x <= hx - 2 *eps) {
+                return 4; // Left boundary
+            } else if (x >= 0.5 * y + 1.5 - hx + 2 * eps) {
+                return 5; // Upper right boundary
+            } else {
+                return 1; // Active interior point
+            }
+        } else {
+            return 0;
+        }
+    }
+    else if (y >= (-2.0 - eps) && y <= -1.0) {
+        if (x >= -eps && x <= (-y + eps)) {
+            if (x <= hx - 2 * eps) {
+                return 4; // Left boundary
+            } else if (x >= -y - hx + 2 * eps) {
+                return 6; // Lower right boundary
+            } else if (y <= -2.0 + hy - 2 * eps) {
+                return 7; // Bottom boundary
+            } else {
+                return 1; // Active interior point
+            }
+        } else {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief The region divider of the Dirichlet example applied to a whole grid line.
+ */
+void dirichlet_line_divider(double x, const double *y, int n, double hx, double hy, unsigned char *region) {
+    for (int j = 0; j < n; j++) {
+        int region_value = dirichlet_region_divider(x, y[j], hx, hy);
+        region[j] = region_value > 0 ? (unsigned char)region_value : 0;
+    }
+}
+
+/**
+ * @brief Whether the numbering of a grid is the serial i-major sweep over its region array.
+ */
+int check_index_sweep(const Grid2D *grid) {
+    int k = 0, n_interior = 0, same = 1;
+    for (int i = 0; i < grid->nx; i++) {
+        for (int j = 0; j < grid->ny; j++) {
+            if (grid_region(grid, i, j) > 0) {
+                if (k >= grid->n_active || grid_id(grid, i, j) != k || grid->id_i[k] != i || grid->id_j[k] != j) same = 0;
+                n_interior += grid_region(grid, i, j) == 1;
+                k++;
+            } else if (grid_id(grid, i, j) != -1) {
+                same = 0;
+            }
+        }
+    }
+    return same && k == grid->n_active && n_interior == grid->n_interior;
+}
+
+/**
+ * @brief initialize_Grid_lines() against initialize_Grid() with the same divider, both numbered by the serial sweep.
+ */
+void test_initialize_lines(int nx, int ny) {
+    Grid2D *grid = initialize_Grid(nx, ny, 0.0, 2.0, -2.0, 2.0, dirichlet_region_divider);
+    Grid2D *grid_lines = initialize_Grid_lines(nx, ny, 0.0, 2.0, -2.0, 2.0, dirichlet_line_divider);
+    int same = grid->n_active == grid_lines->n_active && grid->n_interior == grid_lines->n_interior;
+    for (size_t p = 0; same && p < (size_t)nx * ny; p++) {
+        if (grid->region[p] != grid_lines->region[p] || grid->id_map[p] != grid_lines->id_map[p]) same = 0;
+    }
+    char name[80];
+    snprintf(name, sizeof(name), "initialize_Grid numbers %d x %d like the serial sweep", nx, ny);
+    test_check(check_index_sweep(grid), name);
+    snprintf(name, sizeof(name), "initialize_Grid_lines matches initialize_Grid on %d x %d", nx, ny);
+    test_check(same && check_index_sweep(grid_lines), name);
+    free_grid(grid);
+    free_grid(grid_lines);
+}
+
+/**
+ * @brief Polygon classification of the Dirichlet domain against its region divider on an nx x ny grid.
+ * @note The divider tags the slanted edges by hx only, so it is exact on grids with hx == hy.
+ */
+void test_classify_Dirichlet(int nx, int ny) {
+    double x[] = {0.0, 2.0, 1.0, 2.0, 1.0, 0.0};
+    double y[] = {-2.0, -2.0, -1.0, 1.0, 2.0, 1.0};
+    int tags[] = {7, 6, 5, 3, 2, 4};
+    Geometry2D *domain = create_Geometry2D();
+    add_polygon_Geometry2D(domain, 6, x, y, tags);
+    Grid2D *grid = initialize_Grid_geometry(nx, ny, 0.0, 2.0, -2.0, 2.0, domain);
+    Grid2D *grid_ref = initialize_Grid(nx, ny, 0.0, 2.0, -2.0, 2.0, dirichlet_region_divider);
+    free_Geometry2D(domain);
+
+    int same = grid->n_active == grid_ref->n_active && grid->n_interior == grid_ref->n_interior;
+    for (size_t p = 0; same && p < (size_t)nx * ny; p++) {
+        if (grid->region[p] != grid_ref->region[p] || grid->id_map[p] != grid_ref->id_map[p]) same = 0;
+    }
+    char name[80];
+    snprintf(name, sizeof(name), "classify_Geometry2D matches the region divider on %d x %d", nx, ny);
+    test_check(same, name);
+    free_grid(grid);
+    free_grid(grid_ref);
+}
+
+/**
+ * @brief Every slot of the neighbour table against the index map of the neighbouring point.
+ */
+void test_neighbors(Grid2D *grid) {
+    const int *neighbors = build_neighbors_Grid(grid);
+    int same = neighbors == grid->neighbors, n_exterior = 0, n_off_grid = 0;
+    for (int k = 0; k < grid->n_active; k++) {
+        int i = grid->id_i[k], j = grid->id_j[k];
+        const int *row = grid_neighbors(grid, k);
+        int expected[GRID_N_NEIGHBORS];
+        expected[GRID_LEFT] = i > 0 ? grid_id(grid, i - 1, j) : -1;
+        expected[GRID_RIGHT] = i < grid->nx - 1 ? grid_id(grid, i + 1, j) : -1;
+        expected[GRID_DOWN] = j > 0 ? grid_id(grid, i, j - 1) : -1;
+        expected[GRID_UP] = j < grid->ny - 1 ? grid_id(grid, i, j + 1) : -1;
+        n_off_grid += (i == 0) + (i == grid->nx - 1) + (j == 0) + (j == grid->ny - 1);
+        for (int d = 0; d < GRID_N_NEIGHBORS; d++) {
+            if (row[d] != expected[d]) same = 0;
+            n_exterior += expected[d] < 0;
+        }
+    }
+    n_exterior -= n_off_grid;
+    char name[80];
+    snprintf(name, sizeof(name), "Neighbour table matches the index map on %d x %d", grid->nx, grid->ny);
+    test_check(same && n_exterior > 0 && n_off_grid > 0, name);
+}
+
+/**
+ * @brief Strips own every active point once, contain their own points and cover the grid.
+ */
+void test_strip_partition(Grid2D *grid, int n_parts, int overlap) {
+    int n = grid->n_active;
+    int *owner = (int *)malloc(n * sizeof(int));
+    int *part_ptr = (int *)malloc((n_parts + 1) * sizeof(int));
+    int *parts = strip_partition_Grid(grid, n_parts, overlap, owner, part_ptr);
+    int *count = (int *)calloc(n, sizeof(int));
+    int *own_seen = (int *)calloc(n, sizeof(int));
+
+    int owners_valid = 1, ptr_valid = part_ptr[0] == 0, indices_valid = 1;
+    for (int k = 0; k < n; k++) {
+        if (owner[k] < 0 || owner[k] >= n_parts) owners_valid = 0;
+    }
+    for (int s = 0; s < n_parts; s++) {
+        if (part_ptr[s + 1] < part_ptr[s]) ptr_valid = 0;
+    }
+    if (ptr_valid) {
+        for (int s = 0; s < n_parts; s++) {
+            for (int p = part_ptr[s]; p < part_ptr[s + 1]; p++) {
+                int k = parts[p];
+                if (k < 0 || k >= n) {
+                    indices_valid = 0;
+                    continue;
+                }
+                count[k]++;
+                if (owners_valid && owner[k] == s) own_seen[k]++;
+            }
+        }
+    }
+    // Without overlap the strips are disjoint
+    int covered = ptr_valid && indices_valid, owned = owners_valid && covered;
+    for (int k = 0; k < n; k++) {
+        if (count[k] == 0 || (overlap == 0 && count[k] != 1)) covered = 0;
+        if (own_seen[k] != 1) owned = 0;
+    }
+    char name[80];
+    snprintf(name, sizeof(name), "strip_partition_Grid(%d, %d) is well formed", n_parts, overlap);
+    test_check(owners_valid && ptr_valid && indices_valid, name);
+    snprintf(name, sizeof(name), "strip_partition_Grid(%d, %d) strips cover the grid", n_parts, overlap);
+    test_check(covered, name);
+    snprintf(name, sizeof(name), "strip_partition_Grid(%d, %d) strips hold their points once", n_parts, overlap);
+    test_check(owned, name);
+
+    free(owner);
+    free(part_ptr);
+    free(parts);
+    free(count);
+    free(own_seen);
+}
+
+/**
+ * @brief Scatter a vector to the grid and gather it back, through both array layouts.
+ */
+void test_gather_scatter(Grid2D *grid) {
+    int n = grid->n_active;
+    double *u = (double *)malloc(n * sizeof(double));
+    double *v = (double *)malloc(n * sizeof(double));
+    for (int k = 0; k < n; k++) {
+        u[k] = sin(0.37 * k) + 1.0 / (k + 3);
+    }
+
+    // Exterior points of a dirty array must come back as 0
+    double **points = create_grid_2D_array(grid);
+    for (int i = 0; i < grid->nx; i++) {
+        for (int j = 0; j < grid->ny; j++) points[i][j] = -1.0;
+    }
+    read_indices_to_points(grid, u, points);
+    int placed = 1;
+    for (int i = 0; i < grid->nx; i++) {
+        for (int j = 0; j < grid->ny; j++) {
+            int k = grid_id(grid, i, j);
+            if (points[i][j] != (k >= 0 ? u[k] : 0.0)) placed = 0;
+        }
+    }
+    read_points_to_indices(grid, points, v);
+    char name[80];
+    snprintf(name, sizeof(name), "read_indices_to_points places the values on %d x %d", grid->nx, grid->ny);
+    test_check(placed, name);
+    snprintf(name, sizeof(name), "read_points_to_indices gathers them back on %d x %d", grid->nx, grid->ny);
+    test_check(same_values(u, v, n), name);
+    free_grid_2D_array(points, grid);
+
+    double *array = (double *)malloc((size_t)grid->nx * grid->ny * sizeof(double));
+    for (size_t p = 0; p < (size_t)grid->nx * grid->ny; p++) array[p] = -1.0;
+    read_indices_to_array(grid, u, array);
+    placed = 1;
+    for (size_t p = 0; p < (size_t)grid->nx * grid->ny; p++) {
+        int k = grid->id_map[p];
+        if (array[p] != (k >= 0 ? u[k] : 0.0)) placed = 0;
+    }
+    for (int k = 0; k < n; k++) v[k] = 0.0;
+    read_array_to_indices(grid, array, v);
+    snprintf(name, sizeof(name), "read_indices_to_array places the values on %d x %d", grid->nx, grid->ny);
+    test_check(placed, name);
+    snprintf(name, sizeof(name), "read_array_to_indices gathers them back on %d x %d", grid->nx, grid->ny);
+    test_check(same_values(u, v, n), name);
+
+    free(array);
+    free(u);
+    free(v);
+}
+
+/**
+ * @brief Main function running the grid checks.
+ * @return Number of failed checks.
+ */
+int main() {
+# ifdef _OPENMP
+    omp_set_num_threads(TEST_THREADS);
+# endif
+    Grid2D *grid = create_test_grid(TEST_N);
+    printf("Test grid: %d active points\n", grid->n_active);
+
+    test_neighbors(grid);
+
+    test_strip_partition(grid, 1, 0);
+    test_strip_partition(grid, 4, 0);
+    test_strip_partition(grid, 4, 2);
+    test_strip_partition(grid, 7, 3);
+    test_gather_scatter(grid);
+    Grid2D *grid_large = create_test_grid(TEST_N_LARGE);
+    test_check(check_index_sweep(grid_large), "initialize_Grid_geometry numbers 301 x 301 like the serial sweep");
+    test_neighbors(grid_large);
+    test_gather_scatter(grid_large);
+    free_grid(grid_large);
+
+    test_classify_Dirichlet(21, 41);
+    test_classify_Dirichlet(41, 81);
+    test_classify_Dirichlet(81, 161);
+
+    // 41 x 81 is classified serially, 201 x 401 above GRID_PARALLEL_MIN_POINTS in parallel
+    test_initialize_lines(41, 81);
+    test_initialize_lines(201, 401);
+
+    free_grid(grid);
+    printf("%d check(s) failed\n", test_failures);
+    return test_failures;
+}
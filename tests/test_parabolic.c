@@ -0,0 +1,106 @@
+/**
+ * @file test_parabolic.c
+ * @brief Check the extrapolation of initial guesses from the solution history.
+ *
+ * @details
+ * Sequences of integer-valued vectors that are constant, linear or quadratic in the
+ * step number are pushed into histories of depth 1 to 3. The extrapolation through
+ * q stored solutions is a polynomial of degree q - 1, so it must reproduce every
+ * sequence of lower degree exactly, also after the ring buffer wrapped around, and
+ * fall back to the lower orders while fewer solutions are stored. The program prints
+ * one line per check and returns the number of failed checks.
+ *
+ * Usage:
+ * Compile the program and run it.
+ *
+ * Example:
+ * \verbatim
+   mkdir build && cd build
+   cmake ..
+   make
+   ../bin/test_parabolic \endverbatim
+ * @see parabolic.h, test_utils.h
+ * @author Li Zhijun
+ * @date 2025-12-22
+ * @test test_parabolic.c
+ */
+# include <stdio.h>
+# include <stdlib.h>
+# include "parabolic.h"
+# include "test_utils.h"
+
+/** Length of the stored vectors, above the threading threshold of vec.c. */
+# define TEST_N 40000
+
+/** Steps pushed into every history, enough to wrap the ring buffer around. */
+# define TEST_STEPS 7
+
+/**
+ * @brief Entry i at step k of a sequence of the given degree, integer-valued so that it is exact.
+ */
+double sequence_value(int degree, int i, int k) {
+    double c0 = i % 5 - 2, c1 = i % 3 - 1, c2 = i % 4 - 2;
+    double value = c0;
+    if (degree >= 1) value += c1 * k;
+    if (degree >= 2) value += c2 * k * k;
+    return value;
+}
+
+/**
+ * @brief Push a sequence of the given degree into a history of the given depth and check every extrapolation.
+ * @return 1 if every guess equals the exact next value once enough solutions are stored, and the
+ *         lower-order extrapolation before.
+ */
+int check_history(int depth, int degree) {
+    SolutionHistory *history = create_Solution_History(TEST_N, depth);
+    double *u = (double *)malloc(TEST_N * sizeof(double));
+    double *guess = (double *)malloc(TEST_N * sizeof(double));
+    int exact = 1;
+
+    // An empty history leaves the guess untouched
+    for (int i = 0; i < TEST_N; i++) guess[i] = -1.0;
+    extrapolate_Solution_History(history, guess);
+    for (int i = 0; i < TEST_N; i++) {
+        if (guess[i] != -1.0) exact = 0;
+    }
+
+    for (int k = 0; k < TEST_STEPS; k++) {
+        for (int i = 0; i < TEST_N; i++) u[i] = sequence_value(degree, i, k);
+        push_Solution_History(history, u);
+        extrapolate_Solution_History(history, guess);
+        int stored = k + 1 < depth ? k + 1 : depth;
+        for (int i = 0; i < TEST_N; i++) {
+            double expected;
+            if (stored > degree) {
+                expected = sequence_value(degree, i, k + 1);
+            } else if (stored == 1) {
+                expected = sequence_value(degree, i, k);
+            } else {
+                expected = 2.0 * sequence_value(degree, i, k) - sequence_value(degree, i, k - 1);
+            }
+            if (guess[i] != expected) exact = 0;
+        }
+    }
+
+    free(u);
+    free(guess);
+    free_Solution_History(history);
+    return exact;
+}
+
+/**
+ * @brief Main function running the solution history checks.
+ * @return Number of failed checks.
+ */
+int main() {
+    const char *names[] = {"constant", "linear", "quadratic"};
+    for (int depth = 1; depth <= 3; depth++) {
+        for (int degree = 0; degree <= 2; degree++) {
+            char name[80];
+            snprintf(name, sizeof(name), "Depth %d history extrapolates a %s sequence", depth, names[degree]);
+            test_check(check_history(depth, degree), name);
+        }
+    }
+    printf("%d check(s) failed\n", test_failures);
+    return test_failures;
+}
@@ -0,0 +1,394 @@
+/**
+ * @file test_solvers.c
+ * @brief Check the iterative and direct solvers against a dense direct solve.
+ *
+ * @details
+ * The Dirichlet problem -Laplace(u) = f is assembled by assemble_Matrix_Dirichlet() on an
+ * L-shaped domain, and every solver is compared with the dense reference solution of
+ * the same system. The program prints one line per check and returns the number of
+ * failed checks.
+ *
+ * Usage:
+ * Compile the program and run it.
+ *
+ * Example:
+ * \verbatim
+   mkdir build && cd build
+   cmake ..
+   make
+   ../bin/test_solvers \endverbatim
+ * @see csr.h, test_utils.h
+ * @author Li Zhijun
+ * @date 2025-12-22
+ * @test test_solvers.c
+ */
+# include <stdio.h>
+# include <stdlib.h>
+# include <math.h>
+# include "csr.h"
+# include "geometry.h"
+# include "poisson2d.h"
+# include "precond.h"
+# include "ldlt.h"
+# include "band.h"
+# include "fastpoisson.h"
+# include "test_utils.h"
+
+/** Grid points per direction of the test problem. */
+# define TEST_N 25
+
+/** Tolerance of the iterative solvers and of the comparison with the direct solve. */
+# define TEST_TOL 1e-10
+# define TEST_MATCH 1e-7
+
+double compute_f(double x, double y) {
+    return 2.0 * M_PI * M_PI * sin(M_PI * x) * sin(M_PI * y) + 1.0;
+}
+
+double compute_boundary_value(double x, double y, int boundary_type) {
+    return x * x - y + 0.1 * boundary_type;
+}
+
+/**
+ * @brief Grid of the L-shaped domain [0, 1]^2 without (0.5, 1] x (0.5, 1], one tag per edge.
+ */
+Grid2D* create_test_grid() {
+    double x[] = {0.0, 1.0, 1.0, 0.5, 0.5, 0.0};
+    double y[] = {0.0, 0.0, 0.5, 0.5, 1.0, 1.0};
+    int tags[] = {2, 3, 4, 5, 6, 7};
+    Geometry2D *domain = create_Geometry2D();
+    add_polygon_Geometry2D(domain, 6, x, y, tags);
+    Grid2D *grid = initialize_Grid_geometry(TEST_N, TEST_N, 0.0, 1.0, 0.0, 1.0, domain);
+    free_Geometry2D(domain);
+    return grid;
+}
+
+/**
+ * @brief Chebyshev iteration with the spectral interval estimated by Lanczos.
+ */
+void test_Chebyshev(const SparseCSR *matrix, const double *b, const double *x_ref) {
+    int n = matrix->rows;
+    double lambda_min, lambda_max;
+    Lanczos_eig_bounds_csr(matrix, 40, &lambda_min, &lambda_max);
+    double *x = (double *)calloc(n, sizeof(double));
+    Chebyshev_csr(matrix, b, x, 0.9 * lambda_min, 1.05 * lambda_max, 5000, TEST_TOL);
+    test_check(relative_error(x, x_ref, n) < TEST_MATCH, "Chebyshev_csr matches the direct solve");
+    free(x);
+}
+
+/**
+ * @brief s-step CG in both bases, and rejection of blocks of s < 1 iterations.
+ */
+void test_sstep_CG(const SparseCSR *matrix, const double *b, const double *x_ref) {
+    int n = matrix->rows;
+    double *x = (double *)calloc(n, sizeof(double));
+    sstep_CG_csr(matrix, b, x, 4, KRYLOV_BASIS_MONOMIAL, 2000, TEST_TOL);
+    test_check(relative_error(x, x_ref, n) < TEST_MATCH, "sstep_CG_csr (s = 4, monomial) matches the direct solve");
+
+    for (int i = 0; i < n; i++) x[i] = 0.0;
+    sstep_CG_csr(matrix, b, x, 8, KRYLOV_BASIS_NEWTON, 2000, TEST_TOL);
+    test_check(relative_error(x, x_ref, n) < TEST_MATCH, "sstep_CG_csr (s = 8, Newton) matches the direct solve");
+
+    // s = 0 must return at once and leave x untouched
+    int untouched = 1;
+    for (int i = 0; i < n; i++) x[i] = 1.0;
+    sstep_CG_csr(matrix, b, x, 0, KRYLOV_BASIS_MONOMIAL, 2000, TEST_TOL);
+    for (int i = 0; i < n; i++) {
+        if (x[i] != 1.0) untouched = 0;
+    }
+    test_check(untouched, "sstep_CG_csr rejects s = 0");
+
+    // s = 0 only copies the start vector, s < 0 writes nothing
+    double *V = (double *)malloc(n * sizeof(double));
+    for (int i = 0; i < n; i++) V[i] = -1.0;
+    matrix_powers_csr(matrix, b, -1, NULL, NULL, V);
+    int unchanged = 1;
+    for (int i = 0; i < n; i++) {
+        if (V[i] != -1.0) unchanged = 0;
+    }
+    matrix_powers_csr(matrix, b, 0, NULL, NULL, V);
+    test_check(unchanged && relative_error(V, b, n) == 0.0, "matrix_powers_csr handles s = 0 and rejects s < 0");
+    free(V);
+    free(x);
+}
+
+/**
+ * @brief Deflated CG over a sequence of right-hand sides sharing one recycle space.
+ */
+void test_deflated_CG(const SparseCSR *matrix, const double *b) {
+    int n = matrix->rows;
+    double *x = (double *)calloc(n, sizeof(double));
+    double *b_k = (double *)malloc(n * sizeof(double));
+    double *ref_k = (double *)malloc(n * sizeof(double));
+    RecycleSpace *space = createRecycleSpace(n, 4, 8);
+    space->refresh_period = 2;
+    double error = 0.0;
+    // Enough solves to build, use and refresh the space
+    for (int k = 0; k < 6; k++) {
+        for (int i = 0; i < n; i++) {
+            b_k[i] = b[i] * (1.0 + 0.1 * k) + 0.01 * k * (i % 5);
+        }
+        dense_solve_csr(matrix, b_k, ref_k);
+        deflated_CG_csr(matrix, b_k, x, space, 2000, TEST_TOL);
+        double e = relative_error(x, ref_k, n);
+        if (e > error) error = e;
+    }
+    test_check(error < TEST_MATCH && space->n_vec > 0, "deflated_CG_csr matches the direct solve over 6 solves");
+    freeRecycleSpace(space);
+    free(x);
+    free(b_k);
+    free(ref_k);
+}
+
+/**
+ * @brief PCG with the ILU(0) and SSOR preconditioners (level-scheduled triangular solves).
+ */
+void test_PCG(SparseCSR *matrix, const double *b, const double *x_ref) {
+    int n = matrix->rows;
+    double *x = (double *)calloc(n, sizeof(double));
+    ILU0 *ilu = createILU0(matrix);
+    PCG_csr(matrix, b, x, apply_ILU0, ilu, 1000, TEST_TOL);
+    test_check(relative_error(x, x_ref, n) < TEST_MATCH, "PCG_csr with ILU(0) matches the direct solve");
+    freeILU0(ilu);
+
+    for (int i = 0; i < n; i++) x[i] = 0.0;
+    SSORPrecond *ssor = createSSORPrecond(matrix, estimate_SSOR_omega_csr(matrix));
+    PCG_csr(matrix, b, x, apply_SSOR, ssor, 1000, TEST_TOL);
+    test_check(relative_error(x, x_ref, n) < TEST_MATCH, "PCG_csr with SSOR matches the direct solve");
+    freeSSORPrecond(ssor);
+
+    // The level-scheduled triangular solves agree with the row-by-row sweeps (up to the summation order)
+    SplitCSR *split = createSplitCSR(matrix);
+    LevelSchedule *lower = createLevelSchedule(split, 0);
+    LevelSchedule *upper = createLevelSchedule(split, 1);
+    double *y = (double *)malloc(n * sizeof(double));
+    lower_solve_split_csr(split, b, x);
+    lower_solve_levels_csr(split, lower, b, y);
+    int same = relative_error(y, x, n) < 1e-14;
+    upper_solve_split_csr(split, b, x);
+    upper_solve_levels_csr(split, upper, b, y);
+    test_check(same && relative_error(y, x, n) < 1e-14, "Level-scheduled triangular solves agree with the sweeps");
+    freeLevelSchedule(lower);
+    freeLevelSchedule(upper);
+    freeSplitCSR(split);
+    free(y);
+    free(x);
+}
+
+/**
+ * @brief Sparse LDL^T in natural and nested dissection order, and refactorization for new values.
+ */
+void test_SparseLDL(Grid2D *grid, const SparseCSR *matrix, const double *b, const double *x_ref) {
+    int n = matrix->rows;
+    double *x = (double *)malloc(n * sizeof(double));
+    SparseLDL *ldl = createSparseLDL(matrix, NULL);
+    if (ldl) solveSparseLDL(ldl, b, x);
+    test_check(ldl && relative_error(x, x_ref, n) < TEST_MATCH, "SparseLDL (natural order) matches the direct solve");
+    freeSparseLDL(ldl);
+
+    int *perm = (int *)malloc(n * sizeof(int));
+    nested_dissection_Grid(grid, perm);
+    ldl = createSparseLDL(matrix, perm);
+    if (ldl) solveSparseLDL(ldl, b, x);
+    test_check(ldl && relative_error(x, x_ref, n) < TEST_MATCH, "SparseLDL (nested dissection) matches the direct solve");
+
+    // Same pattern, values doubled: the solution halves
+    SparseCSR *scaled = createSparseCSR(n, n, matrix->nnz);
+    for (int i = 0; i <= n; i++) scaled->row_ptr[i] = matrix->row_ptr[i];
+    for (int j = 0; j < matrix->nnz; j++) {
+        scaled->col_ind[j] = matrix->col_ind[j];
+        scaled->values[j] = 2.0 * matrix->values[j];
+    }
+    int status = ldl ? refactorSparseLDL(ldl, scaled) : -1;
+    if (status == 0) solveSparseLDL(ldl, b, x);
+    for (int i = 0; i < n; i++) x[i] *= 2.0;
+    test_check(status == 0 && relative_error(x, x_ref, n) < TEST_MATCH, "refactorSparseLDL solves the rescaled matrix");
+    freeSparseCSR(scaled);
+    freeSparseLDL(ldl);
+    free(perm);
+    free(x);
+}
+
+/**
+ * @brief Banded LU in natural and Reverse Cuthill-McKee order.
+ */
+void test_BandLU(const SparseCSR *matrix, const double *b, const double *x_ref) {
+    int n = matrix->rows;
+    double *x = (double *)malloc(n * sizeof(double));
+    BandLU *lu = createBandLU(matrix, NULL);
+    if (lu) solveBandLU(lu, b, x);
+    test_check(lu && relative_error(x, x_ref, n) < TEST_MATCH, "BandLU (natural order) matches the direct solve");
+    freeBandLU(lu);
+
+    int *perm = (int *)malloc(n * sizeof(int));
+    int kl, ku, kl_rcm, ku_rcm;
+    rcm_order_csr(matrix, perm);
+    bandwidth_csr(matrix, NULL, &kl, &ku);
+    bandwidth_csr(matrix, perm, &kl_rcm, &ku_rcm);
+    lu = createBandLU(matrix, perm);
+    if (lu) solveBandLU(lu, b, x);
+    test_check(lu && relative_error(x, x_ref, n) < TEST_MATCH && kl_rcm + ku_rcm <= kl + ku,
+               "BandLU (RCM order) matches the direct solve");
+    freeBandLU(lu);
+    free(perm);
+    free(x);
+}
+
+/**
+ * @brief Fast Poisson solver with the direct capacitance correction and with its CG fallback.
+ */
+void test_Fast_Poisson(Grid2D *grid, const double *b, const double *x_ref) {
+    int n = grid->n_active;
+    double *x = (double *)malloc(n * sizeof(double));
+    FastPoisson *fast = create_Fast_Poisson(grid);
+    solve_Fast_Poisson(fast, b, x, 1000, TEST_TOL);
+    test_check(fast->cap && relative_error(x, x_ref, n) < TEST_MATCH, "Fast Poisson (dense capacitance) matches the direct solve");
+
+    // Without the factor the capacitance system is solved by CG
+    free(fast->cap);
+    fast->cap = NULL;
+    solve_Fast_Poisson(fast, b, x, 1000, TEST_TOL);
+    test_check(fast->n_iter > 0 && relative_error(x, x_ref, n) < TEST_MATCH, "Fast Poisson (capacitance CG) matches the direct solve");
+    free_Fast_Poisson(fast);
+    free(x);
+}
+
+/**
+ * @brief PCG with the additive Schwarz preconditioner on overlapping strips, without and with coarse space.
+ */
+void test_Schwarz(Grid2D *grid, const SparseCSR *matrix, const double *b, const double *x_ref) {
+    int n = matrix->rows;
+    int n_sub = 4;
+    int *owner = (int *)malloc(n * sizeof(int));
+    int *sub_ptr = (int *)malloc((n_sub + 1) * sizeof(int));
+    int *sub_ind = strip_partition_Grid(grid, n_sub, 2, owner, sub_ptr);
+    double *x = (double *)malloc(n * sizeof(double));
+    for (int coarse = 0; coarse <= 1; coarse++) {
+        for (int i = 0; i < n; i++) x[i] = 0.0;
+        SchwarzPrecond *schwarz = createSchwarzPrecond(matrix, n_sub, sub_ptr, sub_ind, owner, 0, coarse);
+        if (schwarz) PCG_csr(matrix, b, x, apply_Schwarz, schwarz, 1000, TEST_TOL);
+        test_check(schwarz && relative_error(x, x_ref, n) < TEST_MATCH,
+                   coarse ? "PCG_csr with Schwarz + coarse space matches the direct solve"
+                          : "PCG_csr with one-level Schwarz matches the direct solve");
+        freeSchwarzPrecond(schwarz);
+    }
+    free(owner);
+    free(sub_ptr);
+    free(sub_ind);
+    free(x);
+}
+
+/**
+ * @brief SOR and SSOR with the estimated relaxation parameters.
+ */
+void test_SOR(const SparseCSR *matrix, const double *b, const double *x_ref) {
+    int n = matrix->rows;
+    double *x = (double *)calloc(n, sizeof(double));
+    double omega = estimate_SOR_omega_csr(matrix);
+    SOR_csr(matrix, b, x, omega, 5000, TEST_TOL);
+    test_check(omega > 1.0 && omega < 2.0 && relative_error(x, x_ref, n) < TEST_MATCH, "SOR_csr (estimated omega) matches the direct solve");
+
+    for (int i = 0; i < n; i++) x[i] = 0.0;
+    omega = estimate_SSOR_omega_csr(matrix);
+    SSOR_csr(matrix, b, x, omega, 5000, TEST_TOL);
+    test_check(omega > 0.0 && omega < 2.0 && relative_error(x, x_ref, n) < TEST_MATCH, "SSOR_csr (estimated omega) matches the direct solve");
+    free(x);
+}
+
+/**
+ * @brief Old relaxation sweep that searches every row for its diagonal entry.
+ * @details Reference for the cached-diagonal sweeps of Jacobi_csr(), GaussSeidel_csr(),
+ * SOR_csr() and SSOR_csr(): with x_old the sweep is Jacobi, otherwise x is updated in
+ * place with relaxation omega, forward or backward.
+ */
+static void search_row_sweep(const SparseCSR *matrix, const double *b, const double *x_old, double *x,
+                             double omega, int forward) {
+    int n = matrix->rows;
+    for (int k = 0; k < n; k++) {
+        int i = forward ? k : n - 1 - k;
+        double sum = 0.0, diag = 0.0;
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            if (matrix->col_ind[j] == i) diag = matrix->values[j];
+            else sum += matrix->values[j] * (x_old ? x_old[matrix->col_ind[j]] : x[matrix->col_ind[j]]);
+        }
+        if (x_old) x[i] = (b[i] - sum) / diag;
+        else x[i] += omega * ((b[i] - sum) / diag - x[i]);
+    }
+}
+
+/**
+ * @brief Cached-diagonal relaxation against the row search, on rows stored out of order.
+ * @details The 5x5 matrix has its diagonal first, in the middle and last, and three rows
+ * with unsorted column indices. Every solver runs a fixed number of sweeps (tol = 0).
+ */
+void test_relaxation_rows() {
+    enum { n = 5, nnz = 15, sweeps = 12 };
+    const int row_ptr[n + 1] = {0, 3, 6, 9, 12, 15};
+    const int col_ind[nnz] = {0, 1, 4,   2, 1, 0,   1, 3, 2,   4, 3, 2,   3, 4, 0};
+    const double values[nnz] = {4.0, -1.0, -0.5,   -1.2, 4.5, -1.0,   -0.8, -1.0, 5.0,
+                                -1.1, 4.2, -1.0,   -0.9, 3.9, -0.7};
+    const double b[n] = {1.0, -2.0, 0.5, 3.0, -1.5};
+    SparseCSR *matrix = createSparseCSR(n, n, nnz);
+    for (int i = 0; i <= n; i++) matrix->row_ptr[i] = row_ptr[i];
+    for (int j = 0; j < nnz; j++) {
+        matrix->col_ind[j] = col_ind[j];
+        matrix->values[j] = values[j];
+    }
+
+    double x[n], x_ref[n], x_old[n];
+    const char *names[] = {"Jacobi_csr", "GaussSeidel_csr", "SOR_csr", "SSOR_csr"};
+    const double omega = 1.3;
+    for (int method = 0; method < 4; method++) {
+        for (int i = 0; i < n; i++) x[i] = x_ref[i] = 0.1 * i;
+        if (method == 0) Jacobi_csr(matrix, b, x, sweeps, 0.0);
+        else if (method == 1) GaussSeidel_csr(matrix, b, x, sweeps, 0.0);
+        else if (method == 2) SOR_csr(matrix, b, x, omega, sweeps, 0.0);
+        else SSOR_csr(matrix, b, x, omega, sweeps, 0.0);
+        for (int iter = 0; iter < sweeps; iter++) {
+            if (method == 0) {
+                for (int i = 0; i < n; i++) x_old[i] = x_ref[i];
+                search_row_sweep(matrix, b, x_old, x_ref, 1.0, 1);
+            } else {
+                search_row_sweep(matrix, b, NULL, x_ref, method == 1 ? 1.0 : omega, 1);
+                if (method == 3) search_row_sweep(matrix, b, NULL, x_ref, omega, 0);
+            }
+        }
+        char name[96];
+        snprintf(name, sizeof(name), "%s matches the row search on unsorted rows", names[method]);
+        test_check(relative_error(x, x_ref, n) < 1e-14, name);
+    }
+    freeSparseCSR(matrix);
+}
+
+/**
+ * @brief Main function running all solver checks.
+ * @return Number of failed checks.
+ */
+int main() {
+    Grid2D *grid = create_test_grid();
+    SparseCSR *matrix = assemble_Matrix_Dirichlet(grid);
+    double *b = assemble_RHS_Dirichlet(grid, compute_f, compute_boundary_value);
+    int n = matrix->rows;
+    printf("Test problem: %d active points, %d nonzeros\n", n, matrix->nnz);
+
+    double *x_ref = (double *)malloc(n * sizeof(double));
+    dense_solve_csr(matrix, b, x_ref);
+
+    test_Chebyshev(matrix, b, x_ref);
+    test_sstep_CG(matrix, b, x_ref);
+    test_deflated_CG(matrix, b);
+    test_PCG(matrix, b, x_ref);
+    test_SparseLDL(grid, matrix, b, x_ref);
+    test_BandLU(matrix, b, x_ref);
+    test_Fast_Poisson(grid, b, x_ref);
+    test_Schwarz(grid, matrix, b, x_ref);
+    test_SOR(matrix, b, x_ref);
+    test_relaxation_rows();
+
+    free(x_ref);
+    free(b);
+    freeSparseCSR(matrix);
+    free_grid(grid);
+    printf("%d check(s) failed\n", test_failures);
+    return test_failures;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file test_spgemm.c
+ * @brief Check the CSR transpose and the sparse matrix-matrix product.
+ *
+ * @details
+ * Random rectangular matrices with sorted columns are transposed twice, which must give
+ * back the original arrays exactly, and multiplied: C = A*B must act on a vector like the
+ * two products A*(B*x), also after the numeric phase is rerun for new values of A.
+ * The program prints one line per check and returns the number of failed checks.
+ *
+ * Usage:
+ * Compile the program and run it.
+ *
+ * Example:
+ * \verbatim
+   mkdir build && cd build
+   cmake ..
+   make
+   ../bin/test_spgemm \endverbatim
+ * @see csr.h, test_utils.h
+ * @author Li Zhijun
+ * @date 2025-12-22
+ * @test test_spgemm.c
+ */
+# include <stdio.h>
+# include <stdlib.h>
+# include "csr.h"
+# include "test_utils.h"
+
+/**
+ * @brief Pseudo-random number in [0, 1) from a linear congruential generator.
+ * @param state Generator state, updated.
+ */
+double next_random(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 8) / 16777216.0;
+}
+
+/**
+ * @brief Random matrix with up to per_row entries in every row, columns sorted and distinct.
+ */
+SparseCSR* create_random_csr(int rows, int cols, int per_row, unsigned int seed) {
+    SparseCSR *matrix = createSparseCSR(rows, cols, rows * per_row);
+    int *mark = (int *)calloc(cols, sizeof(int));
+    int idx = 0;
+    matrix->row_ptr[0] = 0;
+    for (int i = 0; i < rows; i++) {
+        for (int k = 0; k < per_row; k++) {
+            mark[(int)(next_random(&seed) * cols)] = 1;
+        }
+        for (int j = 0; j < cols; j++) {
+            if (mark[j]) {
+                matrix->col_ind[idx] = j;
+                matrix->values[idx] = next_random(&seed) - 0.5;
+                idx++;
+                mark[j] = 0;
+            }
+        }
+        matrix->row_ptr[i + 1] = idx;
+    }
+    matrix->nnz = idx;
+    free(mark);
+    return matrix;
+}
+
+/**
+ * @brief Whether two CSR matrices have bitwise the same shape, pattern and values.
+ */
+int same_csr(const SparseCSR *A, const SparseCSR *B) {
+    if (A->rows != B->rows || A->cols != B->cols || A->nnz != B->nnz) return 0;
+    for (int i = 0; i <= A->rows; i++) {
+        if (A->row_ptr[i] != B->row_ptr[i]) return 0;
+    }
+    for (int j = 0; j < A->nnz; j++) {
+        if (A->col_ind[j] != B->col_ind[j] || A->values[j] != B->values[j]) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Main function running the transpose and SpGEMM checks.
+ * @return Number of failed checks.
+ */
+int main() {
+    int m = 300, k = 200, n = 250;
+    SparseCSR *A = create_random_csr(m, k, 6, 1u);
+    SparseCSR *B = create_random_csr(k, n, 4, 2u);
+
+    SparseCSR *At = transpose_csr(A);
+    SparseCSR *Att = transpose_csr(At);
+    test_check(At->rows == k && At->cols == m && At->nnz == A->nnz, "transpose_csr swaps the dimensions");
+    test_check(same_csr(A, Att), "transpose_csr(transpose_csr(A)) == A");
+
+    // A^T x against the scatter of the rows of A
+    double *x = (double *)malloc(m * sizeof(double));
+    double *y = (double *)malloc(k * sizeof(double));
+    double *y_ref = (double *)calloc(k, sizeof(double));
+    unsigned int seed = 3u;
+    for (int i = 0; i < m; i++) x[i] = next_random(&seed);
+    spmv_csr(At, x, y);
+    for (int i = 0; i < m; i++) {
+        for (int j = A->row_ptr[i]; j < A->row_ptr[i + 1]; j++) {
+            y_ref[A->col_ind[j]] += A->values[j] * x[i];
+        }
+    }
+    test_check(relative_error(y, y_ref, k) < 1e-14, "transpose_csr(A) x equals x^T A");
+
+    // C = A*B against two products
+    SparseCSR *C = spgemm_csr(A, B);
+    double *v = (double *)malloc(n * sizeof(double));
+    double *Bv = (double *)malloc(k * sizeof(double));
+    double *ABv = (double *)malloc(m * sizeof(double));
+    double *Cv = (double *)malloc(m * sizeof(double));
+    for (int j = 0; j < n; j++) v[j] = next_random(&seed) - 0.5;
+    spmv_csr(B, v, Bv);
+    spmv_csr(A, Bv, ABv);
+    spmv_csr(C, v, Cv);
+    test_check(C->rows == m && C->cols == n, "spgemm_csr has the dimensions of A*B");
+    test_check(relative_error(Cv, ABv, m) < 1e-13, "spgemm_csr(A, B) v equals A (B v)");
+
+    // The pattern is reused when only the values of A change
+    for (int j = 0; j < A->nnz; j++) A->values[j] *= -2.0;
+    spgemm_numeric_csr(A, B, C);
+    spmv_csr(A, Bv, ABv);
+    spmv_csr(C, v, Cv);
+    test_check(relative_error(Cv, ABv, m) < 1e-13, "spgemm_numeric_csr updates the values on the same pattern");
+
+    free(x);
+    free(y);
+    free(y_ref);
+    free(v);
+    free(Bv);
+    free(ABv);
+    free(Cv);
+    freeSparseCSR(A);
+    freeSparseCSR(B);
+    freeSparseCSR(At);
+    freeSparseCSR(Att);
+    freeSparseCSR(C);
+    printf("%d check(s) failed\n", test_failures);
+    return test_failures;
+}
@@ -0,0 +1,241 @@
+/**
+ * @file test_spmv.c
+ * @brief Check the tuned SpMV kernels and the fused products against the reference product.
+ *
+ * @details
+ * An anisotropic 5-point operator large enough to be tuned and multiplied in parallel is
+ * multiplied with the reference kernel of spmv_csr() first; every other way of computing
+ * the product is then compared with it. The fused spmv_axpby_csr() and step_Parabolic()
+ * must give bitwise the result of spmv_csr() followed by the separate update, tuned or
+ * not. The program prints one line per check and returns the number of failed checks.
+ *
+ * Usage:
+ * Compile the program and run it.
+ *
+ * Example:
+ * \verbatim
+   mkdir build && cd build
+   cmake ..
+   make
+   ../bin/test_spmv \endverbatim
+ * @see spmv.h, parabolic.h, test_utils.h
+ * @author Li Zhijun
+ * @date 2025-12-22
+ * @test test_spmv.c
+ */
+# include <stdio.h>
+# include <stdlib.h>
+# include <math.h>
+# include "csr.h"
+# include "spmv.h"
+# include "csrf.h"
+# include "csrv.h"
+# include "geometry.h"
+# include "parabolic.h"
+# include "test_utils.h"
+
+/** Grid points per direction of the test operator, and of the parabolic test grid (above CSR_TERM_PARALLEL_MIN_ROWS points). */
+# define TEST_N 300
+# define TEST_N_GRID 101
+
+/**
+ * @brief Append the entry (col, value) to the row being filled.
+ */
+void push_entry(SparseCSR *matrix, int *idx, int col, double value) {
+    matrix->col_ind[*idx] = col;
+    matrix->values[*idx] = value;
+    (*idx)++;
+}
+
+/**
+ * @brief Anisotropic 5-point operator on an n x n grid, coefficients not representable in binary.
+ */
+SparseCSR* create_test_matrix(int n) {
+    double cx = 0.1, cy = 0.3;
+    int rows = n * n;
+    SparseCSR *matrix = createSparseCSR(rows, rows, 5 * rows);
+    int idx = 0;
+    matrix->row_ptr[0] = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int row = i * n + j;
+            if (i > 0) push_entry(matrix, &idx, row - n, -cx);
+            if (j > 0) push_entry(matrix, &idx, row - 1, -cy);
+            push_entry(matrix, &idx, row, 2.0 * (cx + cy) + 0.01);
+            if (j < n - 1) push_entry(matrix, &idx, row + 1, -cy);
+            if (i < n - 1) push_entry(matrix, &idx, row + n, -cx);
+            matrix->row_ptr[row + 1] = idx;
+        }
+    }
+    matrix->nnz = idx;
+    return matrix;
+}
+
+/**
+ * @brief Whether two vectors are bitwise equal.
+ */
+int same_vector(const double *a, const double *b, int n) {
+    for (int i = 0; i < n; i++) {
+        if (a[i] != b[i]) return 0;
+    }
+    return 1;
+}
+
+double source_term(double x, double y, double t, double hx, double hy) {
+    return sin(M_PI * x) * cos(M_PI * y) * exp(-t) + hx * hy;
+}
+
+double boundary_value(double x, double y, double t, int boundary_type) {
+    return x * x - y + t + 0.1 * boundary_type;
+}
+
+/**
+ * @brief Fused y = alpha*A*x + beta*y + b against spmv_csr() and the update written out.
+ */
+void test_spmv_axpby(SparseCSR *matrix, const double *x) {
+    int n = matrix->rows;
+    double alpha = 0.7, beta = -1.3;
+    double *Ax = (double *)malloc(n * sizeof(double));
+    double *b = (double *)malloc(n * sizeof(double));
+    double *y0 = (double *)malloc(n * sizeof(double));
+    double *y_ref = (double *)malloc(n * sizeof(double));
+    double *y = (double *)malloc(n * sizeof(double));
+    for (int i = 0; i < n; i++) {
+        b[i] = cos(0.02 * i);
+        y0[i] = 1.0 / (i + 1);
+    }
+    untune_spmv_csr(matrix);
+    spmv_csr(matrix, x, Ax);
+    for (int i = 0; i < n; i++) {
+        y_ref[i] = alpha * Ax[i];
+        y_ref[i] += beta * y0[i];
+        y_ref[i] += b[i];
+    }
+    for (int i = 0; i < n; i++) y[i] = y0[i];
+    spmv_axpby_csr(matrix, alpha, x, beta, y, b);
+    test_check(same_vector(y, y_ref, n), "spmv_axpby_csr equals spmv_csr and the update");
+
+    // y is not read when beta is 0, NaN must not leak into the result
+    for (int i = 0; i < n; i++) y[i] = NAN;
+    spmv_axpby_csr(matrix, 1.0, x, 0.0, y, NULL);
+    test_check(same_vector(y, Ax, n), "spmv_axpby_csr with beta = 0 does not read y");
+
+    tune_spmv_csr(matrix);
+    for (int i = 0; i < n; i++) y[i] = y0[i];
+    spmv_axpby_csr(matrix, alpha, x, beta, y, b);
+    test_check(same_vector(y, y_ref, n), "Tuned spmv_axpby_csr equals spmv_csr and the update");
+    untune_spmv_csr(matrix);
+
+    free(Ax);
+    free(b);
+    free(y0);
+    free(y_ref);
+    free(y);
+}
+
+/**
+ * @brief step_Parabolic() against spmv_csr() followed by adding assemble_RHS_Parabolic().
+ */
+void test_step_Parabolic() {
+    double x[] = {0.0, 1.0, 1.0, 0.5, 0.5, 0.0};
+    double y[] = {0.0, 0.0, 0.5, 0.5, 1.0, 1.0};
+    int tags[] = {2, 3, 4, 5, 6, 7};
+    Geometry2D *domain = create_Geometry2D();
+    add_polygon_Geometry2D(domain, 6, x, y, tags);
+    Grid2D *grid = initialize_Grid_geometry(TEST_N_GRID, TEST_N_GRID, 0.0, 1.0, 0.0, 1.0, domain);
+    free_Geometry2D(domain);
+
+    int n = grid->n_active;
+    double tau = estimate_stable_tau_Parabolic_Explicit(grid, 0.9), t = 0.25;
+    SparseCSR *matrix = assemble_Matrix_Parabolic_Explicit(grid, tau);
+    double *u = (double *)malloc(n * sizeof(double));
+    double *rhs = (double *)malloc(n * sizeof(double));
+    double *u_ref = (double *)malloc(n * sizeof(double));
+    double *u_out = (double *)malloc(n * sizeof(double));
+    for (int i = 0; i < n; i++) {
+        u[i] = sin(0.003 * i) + 0.5;
+    }
+    spmv_csr(matrix, u, u_ref);
+    assemble_RHS_Parabolic(grid, source_term, boundary_value, rhs, t, tau);
+    for (int i = 0; i < n; i++) {
+        u_ref[i] += rhs[i];
+    }
+
+    step_Parabolic(grid, matrix, source_term, boundary_value, u, u_out, t, tau);
+    test_check(same_vector(u_out, u_ref, n), "step_Parabolic equals spmv_csr + assemble_RHS_Parabolic");
+    tune_spmv_csr(matrix);
+    step_Parabolic(grid, matrix, source_term, boundary_value, u, u_out, t, tau);
+    test_check(same_vector(u_out, u_ref, n), "Tuned step_Parabolic equals spmv_csr + assemble_RHS_Parabolic");
+
+    free(u);
+    free(rhs);
+    free(u_ref);
+    free(u_out);
+    freeSparseCSR(matrix);
+    free_grid(grid);
+}
+
+/**
+ * @brief Main function running the SpMV checks.
+ * @return Number of failed checks.
+ */
+int main() {
+    SparseCSR *matrix = create_test_matrix(TEST_N);
+    int n = matrix->rows;
+    printf("Test operator: %d rows, %d nonzeros\n", n, matrix->nnz);
+    double *x = (double *)malloc(n * sizeof(double));
+    double *y_ref = (double *)malloc(n * sizeof(double));
+    double *y = (double *)malloc(n * sizeof(double));
+    for (int i = 0; i < n; i++) {
+        x[i] = sin(0.01 * i) + 1.0 / (i + 3);
+    }
+    spmv_csr(matrix, x, y_ref);
+
+    // The tuned kernel, whichever is selected, reproduces the reference bitwise
+    tune_spmv_csr(matrix);
+    printf("Selected kernel: %s\n", name_SpMVPlan(matrix->plan));
+    spmv_csr(matrix, x, y);
+    test_check(matrix->plan && same_vector(y, y_ref, n), "Tuned spmv_csr is bitwise equal to the reference");
+    untune_spmv_csr(matrix);
+    spmv_csr(matrix, x, y);
+    test_check(!matrix->plan && same_vector(y, y_ref, n), "untune_spmv_csr returns to the reference kernel");
+    test_spmv_axpby(matrix, x);
+    test_step_Parabolic();
+
+    // Float values: the error is bounded by the coefficient rounding times sum |a_ij x_j|
+    SparseCSRf *matrix_f = createSparseCSRf(matrix);
+    spmv_csrf(matrix_f, x, y);
+    double rounding = float_rounding_csr(matrix);
+    int within = rounding > 0.0 && rounding <= ldexp(1.0, -24);
+    for (int i = 0; i < n; i++) {
+        double bound = 0.0;
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            bound += fabs(matrix->values[j] * x[matrix->col_ind[j]]);
+        }
+        if (fabs(y[i] - y_ref[i]) > rounding * bound * (1.0 + 1e-6) + 1e-15 * bound) within = 0;
+    }
+    test_check(within, "spmv_csrf stays within the coefficient rounding bound");
+    freeSparseCSRf(matrix_f);
+
+    // Value-indexed storage holds the three coefficients exactly
+    SparseCSRv *matrix_v = createSparseCSRv(matrix);
+    if (matrix_v) spmv_csrv(matrix_v, x, y);
+    test_check(matrix_v && count_values_csr(matrix) == 3 && matrix_v->n_values == 3 && same_vector(y, y_ref, n),
+               "spmv_csrv is bitwise equal to the reference");
+    freeSparseCSRv(matrix_v);
+
+    // More distinct values than one-byte indices can address
+    SparseCSR *varied = create_test_matrix(20);
+    for (int j = 0; j < varied->nnz; j++) {
+        varied->values[j] *= 1.0 + 1e-3 * j;
+    }
+    test_check(createSparseCSRv(varied) == NULL, "createSparseCSRv rejects more than CSRV_MAX_VALUES values");
+    freeSparseCSR(varied);
+
+    free(x);
+    free(y);
+    free(y_ref);
+    freeSparseCSR(matrix);
+    printf("%d check(s) failed\n", test_failures);
+    return test_failures;
+}
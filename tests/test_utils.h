@@ -0,0 +1,98 @@
+/**
+ * @file test_utils.h
+ * @brief Helpers shared by the test programs: checks and a dense reference solver.
+ *
+ * @details
+ * Every check prints its name and whether it passed; a test program returns the
+ * number of failed checks, so it exits with 0 only if all of them passed. Solvers
+ * are checked against dense_solve_csr(), Gaussian elimination with partial pivoting
+ * on the dense copy of the matrix, which is only meant for the small test matrices.
+ * @see csr.h
+ * @author Li Zhijun
+ * @date 2025-12-22
+ */
+# ifndef TEST_UTILS_H
+# define TEST_UTILS_H
+# include <stdio.h>
+# include <stdlib.h>
+# include <math.h>
+# include "csr.h"
+
+/** Number of failed checks of the test program. */
+static int test_failures = 0;
+
+/**
+ * @brief Report a check and count it if it failed.
+ * @param passed Nonzero if the check passed.
+ * @param name Description of the check.
+ */
+static inline void test_check(int passed, const char *name) {
+    printf("%-60s %s\n", name, passed ? "passed" : "FAILED");
+    if (!passed) test_failures++;
+}
+
+/**
+ * @brief Largest absolute difference of two vectors relative to the largest entry of the reference.
+ * @param x Vector to check.
+ * @param ref Reference vector.
+ * @param n Length of both vectors.
+ */
+static inline double relative_error(const double *x, const double *ref, int n) {
+    double diff = 0.0, scale = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (fabs(x[i] - ref[i]) > diff) diff = fabs(x[i] - ref[i]);
+        if (fabs(ref[i]) > scale) scale = fabs(ref[i]);
+    }
+    return scale > 0.0 ? diff / scale : diff;
+}
+
+/**
+ * @brief Solve Ax = b directly by Gaussian elimination with partial pivoting on a dense copy of A.
+ * @param matrix Pointer to the square SparseCSR matrix (A).
+ * @param b Right-hand side vector.
+ * @param x Solution vector.
+ */
+static inline void dense_solve_csr(const SparseCSR *matrix, const double *b, double *x) {
+    int n = matrix->rows;
+    double *a = (double *)calloc((size_t)n * n, sizeof(double));
+    for (int i = 0; i < n; i++) {
+        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
+            a[(size_t)i * n + matrix->col_ind[j]] += matrix->values[j];
+        }
+        x[i] = b[i];
+    }
+    for (int k = 0; k < n; k++) {
+        int pivot = k;
+        for (int i = k + 1; i < n; i++) {
+            if (fabs(a[(size_t)i * n + k]) > fabs(a[(size_t)pivot * n + k])) pivot = i;
+        }
+        if (pivot != k) {
+            for (int j = 0; j < n; j++) {
+                double t = a[(size_t)k * n + j];
+                a[(size_t)k * n + j] = a[(size_t)pivot * n + j];
+                a[(size_t)pivot * n + j] = t;
+            }
+            double t = x[k];
+            x[k] = x[pivot];
+            x[pivot] = t;
+        }
+        for (int i = k + 1; i < n; i++) {
+            double l = a[(size_t)i * n + k] / a[(size_t)k * n + k];
+            if (l == 0.0) continue;
+            for (int j = k; j < n; j++) {
+                a[(size_t)i * n + j] -= l * a[(size_t)k * n + j];
+            }
+            x[i] -= l * x[k];
+        }
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        double sum = x[i];
+        for (int j = i + 1; j < n; j++) {
+            sum -= a[(size_t)i * n + j] * x[j];
+        }
+        x[i] = sum / a[(size_t)i * n + i];
+    }
+    free(a);
+}
+
+# endif
@@ -0,0 +1,240 @@
+/**
+ * @file test_vec.c
+ * @brief Check the BLAS-1 layer of vec.c: updates, elementwise operations and reductions.
+ *
+ * @details
+ * The reductions must give bitwise the same result for any number of OpenMP threads,
+ * and the compensated variants must recover the rounding errors of the sums and of the
+ * products, including without a fused multiply-add. The updates and elementwise
+ * operations are compared with the loops written out, on lengths that are not multiples
+ * of the SIMD width and above the threading threshold, with aliased outputs; every
+ * operation must give bitwise the same result with the AVX2 and the scalar kernels.
+ * The program prints one line per check and returns the number of failed checks.
+ *
+ * Usage:
+ * Compile the program and run it.
+ *
+ * Example:
+ * \verbatim
+   mkdir build && cd build
+   cmake ..
+   make
+   ../bin/test_vec \endverbatim
+ * @see vec.h, test_utils.h
+ * @author Li Zhijun
+ * @date 2025-12-22
+ * @test test_vec.c
+ */
+# include <stdio.h>
+# include <stdlib.h>
+# include <math.h>
+# include "vec.h"
+# include "test_utils.h"
+# ifdef _OPENMP
+# include <omp.h>
+# endif
+
+/** Threads of the parallel run compared with the serial one. */
+# define TEST_THREADS 4
+
+/** Number of vectors of the multi-dot product. */
+# define TEST_MDOT 3
+
+/**
+ * @brief Reductions of a, b on the current number of threads.
+ */
+void reduce_all(const double *a, const double *b, int n, double *result) {
+    result[0] = vec_dot(a, b, n);
+    result[1] = vec_sum(a, n);
+    result[2] = vec_norm2(a, n);
+    result[3] = vec_dot_compensated(a, b, n);
+    result[4] = vec_sum_compensated(a, n);
+}
+
+/**
+ * @brief Whether two vectors are bitwise equal.
+ */
+int same_vector(const double *a, const double *b, int n) {
+    for (int i = 0; i < n; i++) {
+        if (a[i] != b[i]) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Updates and elementwise operations of length n against the loops written out.
+ * @return 1 if every operation matched bitwise.
+ */
+int check_elementwise(int n) {
+    double alpha = 0.3, beta = -1.7;
+    double *x = (double *)malloc((n + 1) * sizeof(double));
+    double *y = (double *)malloc((n + 1) * sizeof(double));
+    double *w = (double *)malloc((n + 1) * sizeof(double));
+    double *ref = (double *)malloc((n + 1) * sizeof(double));
+    int same = 1;
+    for (int i = 0; i < n; i++) {
+        x[i] = sin(0.01 * i) + 0.1;
+        y[i] = cos(0.013 * i) + 1.5;
+    }
+
+    // vec_axpy: w = w + alpha * x
+    for (int i = 0; i < n; i++) {
+        w[i] = y[i];
+        ref[i] = y[i] + alpha * x[i];
+    }
+    vec_axpy(w, alpha, x, n);
+    same = same && same_vector(w, ref, n);
+
+    // vec_axpby: w = alpha * x + beta * w, and w not read when beta is 0
+    for (int i = 0; i < n; i++) {
+        w[i] = y[i];
+        ref[i] = alpha * x[i] + beta * y[i];
+    }
+    vec_axpby(w, alpha, x, beta, n);
+    same = same && same_vector(w, ref, n);
+    for (int i = 0; i < n; i++) {
+        w[i] = NAN;
+        ref[i] = alpha * x[i];
+    }
+    vec_axpby(w, alpha, x, 0.0, n);
+    same = same && same_vector(w, ref, n);
+
+    // vec_waxpby into a third vector and into either input
+    for (int i = 0; i < n; i++) {
+        ref[i] = alpha * x[i] + beta * y[i];
+    }
+    vec_waxpby(w, alpha, x, beta, y, n);
+    same = same && same_vector(w, ref, n);
+    vec_copy(w, x, n);
+    vec_waxpby(w, alpha, w, beta, y, n);
+    same = same && same_vector(w, ref, n);
+    vec_copy(w, y, n);
+    vec_waxpby(w, alpha, x, beta, w, n);
+    same = same && same_vector(w, ref, n);
+
+    // Elementwise product and quotient, in place in the first input
+    for (int i = 0; i < n; i++) {
+        ref[i] = x[i] * y[i];
+    }
+    vec_copy(w, x, n);
+    vec_pointwise_mult(w, w, y, n);
+    same = same && same_vector(w, ref, n);
+    for (int i = 0; i < n; i++) {
+        ref[i] = x[i] / y[i];
+    }
+    vec_pointwise_divide(w, x, y, n);
+    same = same && same_vector(w, ref, n);
+
+    // Maximum norm with the largest entry negative and last
+    double norm = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (fabs(x[i]) > norm) norm = fabs(x[i]);
+    }
+    if (n > 0) {
+        x[n - 1] = -2.0 * norm - 1.0;
+        norm = -x[n - 1];
+    }
+    same = same && vec_norm_inf(x, n) == norm;
+
+    free(x);
+    free(y);
+    free(w);
+    free(ref);
+    return same;
+}
+
+/**
+ * @brief Multi-dot product of length n against separate dot products.
+ * @param results Output array of the TEST_MDOT products.
+ * @return 1 if every product matched vec_dot() bitwise.
+ */
+int check_mdot(int n, double *results) {
+    double *a = (double *)malloc((n + 1) * sizeof(double));
+    double *b[TEST_MDOT];
+    int same = 1;
+    for (int i = 0; i < n; i++) {
+        a[i] = sin(0.001 * i) * 1e3 + 1.0 / (i + 1);
+    }
+    for (int q = 0; q < TEST_MDOT; q++) {
+        b[q] = (double *)malloc((n + 1) * sizeof(double));
+        for (int i = 0; i < n; i++) {
+            b[q][i] = cos(0.0007 * (q + 1) * i) - 0.5;
+        }
+    }
+    vec_mdot(a, (const double *const *)b, TEST_MDOT, n, results);
+    for (int q = 0; q < TEST_MDOT; q++) {
+        if (results[q] != vec_dot(a, b[q], n)) same = 0;
+        free(b[q]);
+    }
+    free(a);
+    return same;
+}
+
+/**
+ * @brief Main function running the reduction checks.
+ * @return Number of failed checks.
+ */
+int main() {
+    printf("Kernels: %s\n", vec_simd_name());
+    int n = 1000003;
+    double *a = (double *)malloc(n * sizeof(double));
+    double *b = (double *)malloc(n * sizeof(double));
+    for (int i = 0; i < n; i++) {
+        a[i] = sin(0.001 * i) * 1e3 + 1.0 / (i + 1);
+        b[i] = cos(0.0007 * i) - 0.5;
+    }
+
+    double serial[5], parallel[5];
+# ifdef _OPENMP
+    omp_set_num_threads(1);
+# endif
+    reduce_all(a, b, n, serial);
+# ifdef _OPENMP
+    omp_set_num_threads(TEST_THREADS);
+# endif
+    reduce_all(a, b, n, parallel);
+    test_check(serial[0] == parallel[0], "vec_dot is bitwise equal on 1 and 4 threads");
+    test_check(serial[1] == parallel[1], "vec_sum is bitwise equal on 1 and 4 threads");
+    test_check(serial[2] == parallel[2], "vec_norm2 is bitwise equal on 1 and 4 threads");
+    test_check(serial[3] == parallel[3], "vec_dot_compensated is bitwise equal on 1 and 4 threads");
+    test_check(serial[4] == parallel[4], "vec_sum_compensated is bitwise equal on 1 and 4 threads");
+
+    // x * x - fl(x * x) = 2^-60 for x = 1 + 2^-30: only the product error survives
+    double x = 1.0 + ldexp(1.0, -30);
+    double p = x * x;
+    double u[] = {x, -p}, v[] = {x, 1.0};
+    test_check(vec_dot_compensated(u, v, 2) == ldexp(1.0, -60), "vec_dot_compensated keeps the product rounding error");
+
+    // 1e16 + 1 - 1e16 loses the 1 in plain summation
+    double w[] = {1e16, 1.0, -1e16};
+    test_check(vec_sum_compensated(w, 3) == 1.0, "vec_sum_compensated keeps the summation rounding error");
+
+    // Lengths around the SIMD width and the blocks, above VEC_PARALLEL_MIN and above one chunk of blocks
+    int lengths[] = {0, 1, 3, 5, 7, 13, 1029, 32771, 100003, 1048583};
+    int n_lengths = sizeof(lengths) / sizeof(lengths[0]);
+    int elementwise = 1, mdot = 1, scalar_same = 1;
+    for (int k = 0; k < n_lengths; k++) {
+        double simd[TEST_MDOT + 5], scalar[TEST_MDOT + 5];
+        vec_simd_enable(1);
+        elementwise = elementwise && check_elementwise(lengths[k]);
+        mdot = check_mdot(lengths[k], simd) && mdot;
+        if (lengths[k] <= n) reduce_all(a, b, lengths[k], simd + TEST_MDOT);
+        vec_simd_enable(0);
+        elementwise = elementwise && check_elementwise(lengths[k]);
+        mdot = check_mdot(lengths[k], scalar) && mdot;
+        if (lengths[k] <= n) reduce_all(a, b, lengths[k], scalar + TEST_MDOT);
+        int n_results = lengths[k] <= n ? TEST_MDOT + 5 : TEST_MDOT;
+        for (int q = 0; q < n_results; q++) {
+            if (simd[q] != scalar[q]) scalar_same = 0;
+        }
+    }
+    vec_simd_enable(1);
+    test_check(elementwise, "Updates and elementwise operations equal the loops");
+    test_check(mdot, "vec_mdot is bitwise equal to vec_dot");
+    test_check(scalar_same, "Reductions are bitwise equal with AVX2 and scalar kernels");
+
+    free(a);
+    free(b);
+    printf("%d check(s) failed\n", test_failures);
+    return test_failures;
+}